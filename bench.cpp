@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Candle/Visibility.hpp"
+#include "Candle/Constants.hpp"
+#include "Candle/geometry/Trigonometry.hpp"
+#include "Candle/RadialLight.hpp"
+
+/*
+ * Benchmark of the casting algorithms. It doesn't open any window, so it can
+ * be run in a headless machine. Build it with -DCANDLE_BUILD_BENCH=ON, and
+ * also with -DCANDLE_FAST_TRIG=ON to compare the approximations of sincos.
+ */
+
+const float WORLD_SIZE = 2048.f;
+const float TILE_SIZE = 16.f;
+const int REPETITIONS = 3;
+
+typedef std::chrono::steady_clock Clock;
+
+// Best time of some repetitions, in milliseconds
+template <typename F>
+double measure(F f){
+    double best = 0.0;
+    for(int i = 0; i < REPETITIONS; i++){
+        auto start = Clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        if(i == 0 || elapsed.count() < best){
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+// Square tiles aligned to a grid, 4 edges each
+candle::EdgeVector makeTiles(size_t edges, std::mt19937& rng){
+    std::uniform_int_distribution<int> cell(0, WORLD_SIZE / TILE_SIZE - 1);
+    candle::EdgeVector pool;
+    while(pool.size() < edges){
+        sf::Vector2f a(cell(rng) * TILE_SIZE, cell(rng) * TILE_SIZE);
+        sf::Vector2f b = a + sf::Vector2f(TILE_SIZE, 0.f);
+        sf::Vector2f c = a + sf::Vector2f(TILE_SIZE, TILE_SIZE);
+        sf::Vector2f d = a + sf::Vector2f(0.f, TILE_SIZE);
+        pool.emplace_back(a, b);
+        pool.emplace_back(b, c);
+        pool.emplace_back(c, d);
+        pool.emplace_back(d, a);
+    }
+    return pool;
+}
+
+void benchVisibility(std::mt19937& rng){
+    std::cout << "computeVisibility (batch, range 200)" << std::endl;
+    std::cout << std::setw(10) << "edges"
+              << std::setw(12) << "viewpoints"
+              << std::setw(12) << "ms"
+              << std::setw(16) << "M edge*vp/s" << std::endl;
+    std::uniform_real_distribution<float> coord(0.f, WORLD_SIZE);
+    for(size_t edges: {256, 1024, 4096}){
+        candle::EdgeVector pool = makeTiles(edges, rng);
+        for(size_t count: {64, 256, 1024}){
+            std::vector<candle::Viewpoint> viewpoints(count);
+            for(auto& v: viewpoints){
+                v.position = {coord(rng), coord(rng)};
+                v.range = 200.f;
+            }
+            std::vector<std::vector<sf::Vector2f>> polygons;
+            double ms = measure([&](){
+                candle::computeVisibility(pool, viewpoints, polygons);
+            });
+            std::cout << std::setw(10) << pool.size()
+                      << std::setw(12) << count
+                      << std::setw(12) << std::fixed << std::setprecision(2) << ms
+                      << std::setw(16) << pool.size() * count / ms / 1000.0 << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+void benchSincos(){
+    const int N = 1 << 22;
+    std::vector<float> angles(N);
+    for(int i = 0; i < N; i++){
+        angles[i] = (i * 0.731f) - 1e5f;
+    }
+    volatile float sink = 0.f;
+    double fast = measure([&](){
+        float acc = 0.f;
+        for(float a: angles){
+            float s, c;
+            sfu::sincos(a, s, c);
+            acc += s + c;
+        }
+        sink = acc;
+    });
+    double reference = measure([&](){
+        float acc = 0.f;
+        for(float a: angles){
+            float rad = std::fmod(a, 360.f) * sfu::PI / 180.f;
+            acc += std::sin(rad) + std::cos(rad);
+        }
+        sink = acc;
+    });
+    (void)sink;
+#ifdef CANDLE_FAST_TRIG
+    const char* mode = "CANDLE_FAST_TRIG";
+#else
+    const char* mode = "default";
+#endif
+    std::cout << "sfu::sincos (" << mode << ")" << std::endl;
+    std::cout << "  sfu::sincos:        " << std::fixed << std::setprecision(2) << fast * 1e6 / N << " ns/call" << std::endl;
+    std::cout << "  std::sin, std::cos: " << reference * 1e6 / N << " ns/call" << std::endl;
+    std::cout << "  speed-up:           " << reference / fast << "x" << std::endl;
+    std::cout << std::endl;
+}
+
+void benchRadialLight(std::mt19937& rng){
+    const int CASTS = 10;
+    candle::EdgeVector pool = makeTiles(1024, rng);
+    candle::RadialLight light;
+    light.setRange(300.f);
+    light.setPosition(WORLD_SIZE/2 + 3.5f, WORLD_SIZE/2 + 5.5f);
+    struct Configuration{
+        const char* name;
+        float rotation, beamAngle;
+        bool exact;
+    };
+    Configuration configurations[] = {
+        {"full circle", 0.f, 360.f, false},
+        {"full circle, exact", 0.f, 360.f, true},
+        {"cone", 90.f, 120.f, false},
+        {"cone across 0", 0.f, 120.f, false}
+    };
+    std::cout << "RadialLight::castLight (" << pool.size() << " edges, range 300)" << std::endl;
+    for(auto& c: configurations){
+        light.setRotation(c.rotation);
+        light.setBeamAngle(c.beamAngle);
+        light.setExactCasting(c.exact);
+        double ms = measure([&](){
+            for(int i = 0; i < CASTS; i++){
+                light.castLight(pool.begin(), pool.end());
+            }
+        });
+        std::cout << "  " << std::left << std::setw(20) << c.name << std::right
+                  << std::setw(10) << std::setprecision(3) << ms / CASTS << " ms/cast" << std::endl;
+    }
+}
+
+int main(){
+    std::mt19937 rng(2021);
+    benchVisibility(rng);
+    benchSincos();
+    benchRadialLight(rng);
+    return 0;
+}
@@ -11,5 +11,20 @@
 #include "Candle/RadialLight.hpp"
 #include "Candle/DirectedLight.hpp"
 #include "Candle/LightingArea.hpp"
+#include "Candle/Culling.hpp"
+#include "Candle/LightTree.hpp"
+#include "Candle/Visibility.hpp"
+#include "Candle/Raycast.hpp"
+#include "Candle/LightScheduler.hpp"
+#include "Candle/LightPool.hpp"
+#include "Candle/LightParticles.hpp"
+#include "Candle/LightSampler.hpp"
+#include "Candle/VisionMask.hpp"
+#include "Candle/ExploredMask.hpp"
+#include "Candle/LightSet.hpp"
+#include "Candle/VisibilityCache.hpp"
+#include "Candle/OccluderGroup.hpp"
+#include "Candle/LightMap.hpp"
+#include "Candle/TiledLightingArea.hpp"
 
 #endif
@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the functions to cull lights.
+ */
+#ifndef __CANDLE_CULLING_HPP__
+#define __CANDLE_CULLING_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+#include "Candle/LightTree.hpp"
+
+namespace candle{
+    /**
+     * @brief Visibility of a light relative to a region.
+     * @see testVisibility
+     */
+    enum Visibility {
+        /**
+         * The light can't illuminate any point of the region, so it doesn't
+         * need to be casted nor drawn.
+         */
+        HIDDEN,
+        /**
+         * The light may illuminate part of the region.
+         */
+        PARTIALLY_VISIBLE,
+        /**
+         * The whole area the light may illuminate is inside the region.
+         */
+        VISIBLE
+    };
+
+    /**
+     * @brief Light paired with its visibility.
+     * @see cullLights
+     */
+    struct CulledLight{
+        LightSource* light; ///< The light.
+        Visibility visibility; ///< Visibility of the light.
+    };
+
+    /**
+     * @brief Get the rectangle of the world seen through a view.
+     * @details If the view is rotated, the bounding rectangle of the
+     * seen area is returned.
+     * @param view
+     * @returns Global rectangle seen through the view.
+     */
+    sf::FloatRect getViewBounds(const sf::View& view);
+
+    /**
+     * @brief Test the global bounds of a light against a region.
+     * @param light
+     * @param region Rectangle in global coordinates.
+     * @returns The visibility of the light in the region.
+     */
+    Visibility testVisibility(const LightSource& light, const sf::FloatRect& region);
+
+    /**
+     * @brief Select the lights that aren't hidden in a region.
+     * @details The range must contain pointers (raw or smart) to
+     * LightSources. The lights that are not HIDDEN are appended to
+     * @p visible, so the rest can be skipped when casting and drawing.
+     * @param begin Iterator to the first pointer.
+     * @param end Iterator to the first pointer not to be taken into account.
+     * @param region Rectangle in global coordinates.
+     * @param visible (Output argument) Lights that may illuminate the region.
+     * @see getViewBounds, LightingArea::getGlobalBounds
+     */
+    template <typename Iterator>
+    void cullLights(const Iterator& begin,
+                    const Iterator& end,
+                    const sf::FloatRect& region,
+                    std::vector<CulledLight>& visible){
+        for(auto it = begin; it != end; it++){
+            LightSource& light = **it;
+            Visibility v = testVisibility(light, region);
+            if(v != HIDDEN){
+                CulledLight cl;
+                cl.light = &light;
+                cl.visibility = v;
+                visible.push_back(cl);
+            }
+        }
+    }
+
+    /**
+     * @brief Select the lights of a tree that aren't hidden in a region.
+     * @details Only the lights whose bounds in the tree intersect the
+     * region are tested, so the cost depends on the number of lights near
+     * the region and not on the total. The tree must be updated first.
+     * @param tree
+     * @param region Rectangle in global coordinates.
+     * @param visible (Output argument) Lights that may illuminate the region.
+     * @see LightTree::update
+     */
+    void cullLights(const LightTree& tree,
+                    const sf::FloatRect& region,
+                    std::vector<CulledLight>& visible);
+}
+
+#endif
@@ -34,11 +34,21 @@ namespace candle{
         float m_beamWidth;
         
         void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const override;
         void resetColor() override;
+    protected:
+        void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon) override;
+        void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                         const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                         sf::VertexArray& polygon) override;
+        
     public:
         DirectedLight();
         
-        void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end) override;
+        /**
+         * @brief Destructor
+         */
+        virtual ~DirectedLight();
         
         /**
          * @brief Set the width of the beam.
@@ -57,6 +67,19 @@ namespace candle{
          */
         float getBeamWidth() const;
         
+        sf::FloatRect getLocalBounds() const override;
+        
+        sf::FloatRect getGlobalBounds() const override;
+        
+        /**
+         * @brief Get how much a point is illuminated by the light.
+         * @details The quad that contains the point is found with a binary
+         * search across the beam.
+         * @param point Point in global coordinates.
+         * @returns The intensity of the light at @p point.
+         */
+        float getIllumination(const sf::Vector2f& point) const override;
+        
     };
 }
 
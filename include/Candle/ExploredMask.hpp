@@ -0,0 +1,142 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the ExploredMask class.
+ */
+#ifndef __CANDLE_EXPLORED_MASK_HPP__
+#define __CANDLE_EXPLORED_MASK_HPP__
+
+#include <istream>
+#include <ostream>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/VisionMask.hpp"
+#include "Candle/graphics/SoftwareTarget.hpp"
+
+namespace candle{
+    /**
+     * @brief Memory of the areas that have been seen, for FOG mode.
+     * @details
+     *
+     * A LightingArea in FOG mode only reveals what is visible in the
+     * current frame, because it is cleared every frame. An ExploredMask
+     * divides a region of the world in cells and remembers which of them
+     * have ever been seen. When it is drawn to a FOG area after clearing
+     * it, the explored cells are partially revealed, by the opacity set
+     * with @ref setOpacity, so the player can see the map they already
+     * know under a lighter fog.
+     *
+     * Cells are only added by @ref reveal, and only the rectangle of the
+     * cells newly revealed since the last draw is uploaded to the GPU.
+     *
+     * The mask can be saved and loaded in a compact run-length form, to be
+     * stored in save games.
+     */
+    class ExploredMask: public sf::Drawable{
+    private:
+        friend class LightingArea;
+
+        sf::FloatRect m_area;
+        float m_cellSize;
+        sf::Vector2u m_size;
+        sf::Image m_image;
+        unsigned int m_exploredCount;
+        float m_opacity;
+        sf::VertexArray m_quad;
+        mutable sf::Texture m_texture;
+        mutable bool m_textureCreated;
+        mutable sf::IntRect m_dirty;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+        void uploadDirty() const;
+        void markDirty(unsigned int x, unsigned int y);
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param area Region of the world covered by the mask.
+         * @param cellSize Side of each cell, in world units.
+         */
+        ExploredMask(const sf::FloatRect& area, float cellSize=8.f);
+
+        /**
+         * @brief Forget all the explored cells.
+         */
+        void clear();
+
+        /**
+         * @brief Mark as explored the cells seen by a group of viewpoints.
+         * @details A cell is explored if its center is visible in the
+         * last computation of @p vision. Only the cells under the bounds
+         * of @p vision are checked.
+         * @param vision
+         * @returns The number of cells newly explored.
+         */
+        unsigned int reveal(const VisionMask& vision);
+
+        /**
+         * @brief Mark as explored the cells inside a circle.
+         * @param center Center of the circle.
+         * @param radius Radius of the circle.
+         * @returns The number of cells newly explored.
+         */
+        unsigned int reveal(const sf::Vector2f& center, float radius);
+
+        /**
+         * @brief Check if a point has been explored.
+         * @param point Point in global coordinates.
+         */
+        bool isExplored(const sf::Vector2f& point) const;
+
+        /**
+         * @brief Get the number of explored cells.
+         */
+        unsigned int getExploredCount() const;
+
+        /**
+         * @brief Get the number of cells in each axis.
+         */
+        sf::Vector2u getSize() const;
+
+        /**
+         * @brief Set how much the fog is reduced over the explored areas.
+         * @details The default value is 0.5.
+         * @param opacity Value from 0 (the explored areas aren't revealed)
+         * to 1 (they are fully revealed).
+         * @see getOpacity
+         */
+        void setOpacity(float opacity);
+
+        /**
+         * @brief Get how much the fog is reduced over the explored areas.
+         * @see setOpacity
+         */
+        float getOpacity() const;
+
+        /**
+         * @brief Write the mask to a stream.
+         * @details The cells are written row by row as alternate runs of
+         * unexplored and explored cells, each length in a variable number of
+         * bytes. The stream must be opened in binary mode.
+         * @param os
+         * @returns True if the mask was written successfully.
+         * @see loadFromStream
+         */
+        bool saveToStream(std::ostream& os) const;
+
+        /**
+         * @brief Read the mask from a stream.
+         * @details The mask must have the same number of cells as the one
+         * saved. If the data is invalid, the mask is left unchanged.
+         * @param is
+         * @returns True if the mask was read successfully.
+         * @see saveToStream
+         */
+        bool loadFromStream(std::istream& is);
+    };
+}
+
+#endif
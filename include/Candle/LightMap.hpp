@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the functions to bake, save and load light maps.
+ */
+#ifndef __CANDLE_LIGHTMAP_HPP__
+#define __CANDLE_LIGHTMAP_HPP__
+
+#include <string>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+#include "Candle/LightingArea.hpp"
+
+namespace candle{
+    /**
+     * @brief Render a set of static lights into an area, once.
+     * @details The area is cleared, every light is casted against
+     * @p edges and drawn to it, and the result is displayed and returned.
+     * This is only meaningful for areas in FOG mode, as lights have no effect
+     * in AMBIENT mode. Areas with the SOFTWARE backend can be used to bake
+     * without an OpenGL context.
+     *
+     * The returned image is meant to be saved with @ref saveLightMap and
+     * used later as the base texture of a LightingArea (see
+     * LightingArea::setAreaTexture), so that only dynamic lights need to be
+     * casted and drawn at runtime. Keep the color of that area white and its
+     * opacity at 1, as they multiply the base texture.
+     * @param area
+     * @param edges Edges that cast shadows.
+     * @param lights Static lights to bake.
+     * @returns The content of the area after drawing the lights.
+     */
+    sf::Image bakeLightMap(LightingArea& area, EdgeVector& edges, const std::vector<LightSource*>& lights);
+
+    /**
+     * @brief Save a light map to a file.
+     * @details The image is split in square tiles of @p tileSize pixels that
+     * are stored one after another. If @p compress is set, each tile is
+     * run-length encoded, unless that makes it bigger. Light maps usually
+     * have large areas of plain fog, so they compress well this way.
+     * @param image
+     * @param filename
+     * @param compress
+     * @param tileSize
+     * @returns True if the file was written successfully.
+     * @see loadLightMap
+     */
+    bool saveLightMap(const sf::Image& image, const std::string& filename, bool compress=true, unsigned int tileSize=64);
+
+    /**
+     * @brief Load a light map from a file.
+     * @details Files that declare images wider or taller than 16384 pixels,
+     * or tiles longer than their size allows, are rejected.
+     * @param image (Output argument) Image to store the light map.
+     * @param filename
+     * @returns True if the file was read successfully.
+     * @see saveLightMap
+     */
+    bool loadLightMap(sf::Image& image, const std::string& filename);
+}
+
+#endif
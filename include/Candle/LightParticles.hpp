@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightParticles class.
+ */
+#ifndef __CANDLE_LIGHT_PARTICLES_HPP__
+#define __CANDLE_LIGHT_PARTICLES_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/graphics/SoftwareTarget.hpp"
+
+namespace candle{
+    /**
+     * @brief Set of small lights that are not blocked by edges.
+     * @details
+     *
+     * Sparks, fireflies or muzzle flashes are too small or too short-lived
+     * for their shadows to matter, and making each of them a RadialLight
+     * would require a cast per particle. A LightParticles object stores each
+     * particle as a single quad textured with the same falloff as a
+     * full-circle RadialLight, and draws all of them in one draw call.
+     *
+     * Particles are identified by their index, from 0 to
+     * @ref getParticleCount - 1. Removing a particle moves the last one to
+     * its index.
+     *
+     * Like LightSources, they are drawn with sf::BlendAdd instead of
+     * sf::BlendAlpha, and they can be drawn to a LightingArea in FOG mode.
+     */
+    class LightParticles: public sf::Drawable{
+    private:
+        friend class LightingArea;
+
+        std::vector<sf::Vector2f> m_positions;
+        std::vector<float> m_ranges;
+        sf::VertexArray m_vertices;
+        bool m_fade;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+        void updateQuad(size_t i);
+
+    public:
+        /**
+         * @brief Constructor.
+         */
+        LightParticles();
+
+        /**
+         * @brief Add a particle.
+         * @param position Center of the particle.
+         * @param range Radius of the particle.
+         * @param color The alpha value is ignored.
+         * @param intensity Value from 0 to 1.
+         * @returns The index of the new particle.
+         */
+        size_t add(const sf::Vector2f& position,
+                   float range,
+                   const sf::Color& color=sf::Color::White,
+                   float intensity=1.f);
+
+        /**
+         * @brief Remove a particle.
+         * @details The last particle takes the index @p i.
+         * @param i Index of the particle.
+         */
+        void remove(size_t i);
+
+        /**
+         * @brief Remove all the particles.
+         */
+        void clear();
+
+        /**
+         * @brief Get the number of particles.
+         * @returns The number of particles.
+         */
+        size_t getParticleCount() const;
+
+        /**
+         * @brief Set the center of a particle.
+         * @param i Index of the particle.
+         * @param position
+         */
+        void setPosition(size_t i, const sf::Vector2f& position);
+
+        /**
+         * @brief Get the center of a particle.
+         * @param i Index of the particle.
+         * @returns The center of the particle.
+         */
+        sf::Vector2f getPosition(size_t i) const;
+
+        /**
+         * @brief Set the radius of a particle.
+         * @param i Index of the particle.
+         * @param range
+         */
+        void setRange(size_t i, float range);
+
+        /**
+         * @brief Get the radius of a particle.
+         * @param i Index of the particle.
+         * @returns The radius of the particle.
+         */
+        float getRange(size_t i) const;
+
+        /**
+         * @brief Set the color of a particle.
+         * @param i Index of the particle.
+         * @param color The alpha value is ignored.
+         * @see LightSource::setColor
+         */
+        void setColor(size_t i, const sf::Color& color);
+
+        /**
+         * @brief Get the color of a particle.
+         * @param i Index of the particle.
+         * @returns The color of the particle, with alpha 255.
+         */
+        sf::Color getColor(size_t i) const;
+
+        /**
+         * @brief Set the intensity of a particle.
+         * @param i Index of the particle.
+         * @param intensity Value from 0 to 1.
+         * @see LightSource::setIntensity
+         */
+        void setIntensity(size_t i, float intensity);
+
+        /**
+         * @brief Get the intensity of a particle.
+         * @param i Index of the particle.
+         * @returns The intensity of the particle.
+         */
+        float getIntensity(size_t i) const;
+
+        /**
+         * @brief Set the value of the _fade_ flag of all the particles.
+         * @details The default value is true.
+         * @param fade
+         * @see LightSource::setFade
+         */
+        void setFade(bool fade);
+
+        /**
+         * @brief Check if the particles fade or not.
+         * @returns The value of the _fade_ flag.
+         */
+        bool getFade() const;
+    };
+}
+
+#endif
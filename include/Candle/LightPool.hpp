@@ -0,0 +1,282 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightPool class.
+ */
+#ifndef __CANDLE_LIGHT_POOL_HPP__
+#define __CANDLE_LIGHT_POOL_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+#include "Candle/RadialLight.hpp"
+#include "Candle/DirectedLight.hpp"
+#include "Candle/graphics/SoftwareTarget.hpp"
+
+namespace candle{
+    /**
+     * @brief Container of many lights processed in batch.
+     * @details
+     *
+     * A LightPool is an alternative to keeping many individual
+     * @ref RadialLight "RadialLights" and @ref DirectedLight "DirectedLights"
+     * when there are thousands of them. Instead of objects, the lights are
+     * rows of contiguous arrays (one array per parameter, grouped by the type
+     * of light), and they are referred to by a @ref Handle, that remains
+     * valid until the light is destroyed.
+     *
+     * The lights are casted together with @ref castLights, and the
+     * resulting polygons are stored in global coordinates in a few vertex
+     * arrays, so drawing the whole pool takes one draw call per kind of
+     * light. The pool can be drawn to any sf::RenderTarget or to a
+     * LightingArea, as if it were a single light.
+     *
+     * The changes to the lights (parameters, creation and destruction) are
+     * not visible until the next call to @ref castLights. Changing only the
+     * color or the intensity of a RadialLight doesn't require to cast it
+     * again, it is just recolored.
+     */
+    class LightPool: public sf::Drawable{
+    public:
+        /**
+         * @brief Types of lights of the pool.
+         */
+        enum Type {
+            RADIAL, ///< Lights that behave as a @ref RadialLight.
+            DIRECTED ///< Lights that behave as a @ref DirectedLight.
+        };
+
+        /**
+         * @brief Reference to a light of the pool.
+         * @details When a light is destroyed, its handle never refers to
+         * another light, so it can be checked with @ref isValid.
+         */
+        struct Handle{
+            unsigned int slot; ///< Index in the table of handles.
+            unsigned int generation; ///< Generation of the slot when created.
+        };
+
+    private:
+        friend class LightingArea;
+
+        enum {
+            CAST = 1,
+            RECOLOR = 2
+        };
+
+        struct Slot{
+            Type type;
+            unsigned int index;
+            unsigned int generation;
+        };
+
+        // Parameters of the lights of one type, one array each
+        struct Group{
+            std::vector<sf::Vector2f> position;
+            std::vector<float> rotation;
+            std::vector<float> range;
+            std::vector<float> beam; // angle for RADIAL, width for DIRECTED
+            std::vector<sf::Color> color;
+            std::vector<unsigned char> fade;
+            std::vector<unsigned char> changes;
+            std::vector<unsigned int> slot;
+            // Range of the polygon in the vertex array of its kind
+            std::vector<unsigned int> first;
+            std::vector<unsigned int> count;
+        };
+
+        std::vector<Slot> m_slots;
+        std::vector<unsigned int> m_freeSlots;
+        Group m_groups[2];
+        // Global polygons: radial with fade, radial without fade, directed
+        sf::VertexArray m_vertices[3];
+        RadialLight m_radialCaster;
+        DirectedLight m_directedCaster;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+        Handle create(Type type, float beam);
+        unsigned int index(const Handle& light) const;
+        Group& group(const Handle& light);
+        const Group& group(const Handle& light) const;
+        void castRadial(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+        void castDirected(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+
+    public:
+        /**
+         * @brief Constructor.
+         */
+        LightPool();
+
+        /**
+         * @brief Add a light with the default parameters of a RadialLight.
+         * @returns Handle of the new light.
+         */
+        Handle createRadialLight();
+
+        /**
+         * @brief Add a light with the default parameters of a DirectedLight.
+         * @returns Handle of the new light.
+         */
+        Handle createDirectedLight();
+
+        /**
+         * @brief Remove a light from the pool.
+         * @details The handle becomes invalid. Invalid handles are ignored.
+         * @param light
+         */
+        void destroy(const Handle& light);
+
+        /**
+         * @brief Check if a handle refers to a light of the pool.
+         * @param light
+         * @returns True if the light hasn't been destroyed.
+         */
+        bool isValid(const Handle& light) const;
+
+        /**
+         * @brief Get the type of a light.
+         * @param light Valid handle.
+         * @returns The type of the light.
+         */
+        Type getType(const Handle& light) const;
+
+        /**
+         * @brief Get the number of lights in the pool.
+         * @returns The number of lights.
+         */
+        size_t getLightCount() const;
+
+        /**
+         * @brief Set the position of a light.
+         * @param light Valid handle.
+         * @param position
+         * @see sf::Transformable::setPosition
+         */
+        void setPosition(const Handle& light, const sf::Vector2f& position);
+
+        /**
+         * @brief Get the position of a light.
+         * @param light Valid handle.
+         * @returns The position of the light.
+         */
+        sf::Vector2f getPosition(const Handle& light) const;
+
+        /**
+         * @brief Set the rotation of a light.
+         * @param light Valid handle.
+         * @param angle Angle in degrees.
+         * @see sf::Transformable::setRotation
+         */
+        void setRotation(const Handle& light, float angle);
+
+        /**
+         * @brief Get the rotation of a light.
+         * @param light Valid handle.
+         * @returns The rotation of the light in degrees.
+         */
+        float getRotation(const Handle& light) const;
+
+        /**
+         * @brief Set the range of a light.
+         * @param light Valid handle.
+         * @param range
+         * @see LightSource::setRange
+         */
+        void setRange(const Handle& light, float range);
+
+        /**
+         * @brief Get the range of a light.
+         * @param light Valid handle.
+         * @returns The range of the light.
+         */
+        float getRange(const Handle& light) const;
+
+        /**
+         * @brief Set the color of a light.
+         * @param light Valid handle.
+         * @param color The alpha value is ignored.
+         * @see LightSource::setColor
+         */
+        void setColor(const Handle& light, const sf::Color& color);
+
+        /**
+         * @brief Get the color of a light.
+         * @param light Valid handle.
+         * @returns The color of the light, with alpha 255.
+         */
+        sf::Color getColor(const Handle& light) const;
+
+        /**
+         * @brief Set the intensity of a light.
+         * @param light Valid handle.
+         * @param intensity Value from 0 to 1.
+         * @see LightSource::setIntensity
+         */
+        void setIntensity(const Handle& light, float intensity);
+
+        /**
+         * @brief Get the intensity of a light.
+         * @param light Valid handle.
+         * @returns The intensity of the light.
+         */
+        float getIntensity(const Handle& light) const;
+
+        /**
+         * @brief Set the value of the _fade_ flag of a light.
+         * @param light Valid handle.
+         * @param fade
+         * @see LightSource::setFade
+         */
+        void setFade(const Handle& light, bool fade);
+
+        /**
+         * @brief Check if a light fades or not.
+         * @param light Valid handle.
+         * @returns The value of the _fade_ flag.
+         */
+        bool getFade(const Handle& light) const;
+
+        /**
+         * @brief Set the beam of a light.
+         * @details It is the beam angle for RADIAL lights and the beam width
+         * for DIRECTED lights.
+         * @param light Valid handle.
+         * @param beam
+         * @see RadialLight::setBeamAngle, DirectedLight::setBeamWidth
+         */
+        void setBeam(const Handle& light, float beam);
+
+        /**
+         * @brief Get the beam of a light.
+         * @param light Valid handle.
+         * @returns The beam angle or width of the light.
+         */
+        float getBeam(const Handle& light) const;
+
+        /**
+         * @brief Mark all the lights to be casted in the next call to
+         * @ref castLights.
+         * @details Needed when the edges change.
+         */
+        void invalidate();
+
+        /**
+         * @brief Cast the lights that have changed and rebuild the polygons
+         * of the pool.
+         * @details Only the lights that have been created, moved or
+         * modified since the last call are casted, unless @ref invalidate
+         * is called.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         */
+        void castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+    };
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightSampler class.
+ */
+#ifndef __CANDLE_LIGHT_SAMPLER_HPP__
+#define __CANDLE_LIGHT_SAMPLER_HPP__
+
+#include <unordered_map>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Light received at a point.
+     * @see LightSampler
+     */
+    struct LightSample{
+        /**
+         * Sum of the colors of the lights, each one weighted by its
+         * illumination at the point. The channels go from 0 to 1 for a
+         * single light, and may be greater where lights overlap.
+         */
+        sf::Vector3f color;
+        /**
+         * Sum of the illumination of the lights at the point (see
+         * LightSource::getIllumination).
+         */
+        float intensity;
+    };
+
+    /**
+     * @brief Object to query the light at points of the world on the CPU.
+     * @details
+     *
+     * Gameplay code may need to know how illuminated an entity is (for
+     * example, for stealth), and reading back the texture of a LightingArea
+     * stalls the GPU. A LightSampler answers the same question with the
+     * polygons of the lights, which are already in memory.
+     *
+     * The lights are bucketed by their global bounds in a grid of cells, so
+     * each point is only tested against the lights that may reach it. The
+     * lights are not copied: they must be casted before being added, and
+     * the sampler must be rebuilt (@ref clear and @ref addLight) when they
+     * move or change their range. With many lights, the ones around the
+     * points of interest can be selected with LightTree::query.
+     */
+    class LightSampler{
+    private:
+        float m_cellSize;
+        std::vector<const LightSource*> m_lights;
+        std::vector<sf::FloatRect> m_bounds;
+        std::unordered_map<unsigned long long, std::vector<unsigned int>> m_cells;
+
+        unsigned long long getCellKey(int x, int y) const;
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param cellSize Side of the cells of the grid. It should be close
+         * to the usual range of the lights.
+         */
+        explicit LightSampler(float cellSize=256.f);
+
+        /**
+         * @brief Remove all the lights.
+         */
+        void clear();
+
+        /**
+         * @brief Add a light to be sampled.
+         * @param light
+         */
+        void addLight(const LightSource& light);
+
+        /**
+         * @brief Add a range of lights to be sampled.
+         * @details The range must contain pointers (raw or smart) to
+         * LightSources.
+         * @param begin Iterator to the first pointer.
+         * @param end Iterator to the first pointer not to be taken into
+         * account.
+         */
+        template <typename Iterator>
+        void addLights(const Iterator& begin, const Iterator& end){
+            for(auto it = begin; it != end; it++){
+                addLight(**it);
+            }
+        }
+
+        /**
+         * @brief Get the number of lights added.
+         */
+        size_t getLightCount() const;
+
+        /**
+         * @brief Get the light received at a point.
+         * @param point Point in global coordinates.
+         * @returns The accumulated color and intensity of the lights.
+         */
+        LightSample sample(const sf::Vector2f& point) const;
+
+        /**
+         * @brief Get the light received at many points.
+         * @param points Points in global coordinates.
+         * @param samples (Output argument) Light received at each point, in
+         * the same order.
+         */
+        void sample(const std::vector<sf::Vector2f>& points,
+                    std::vector<LightSample>& samples) const;
+    };
+}
+
+#endif
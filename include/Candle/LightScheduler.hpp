@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightScheduler class.
+ */
+#ifndef __CANDLE_LIGHT_SCHEDULER_HPP__
+#define __CANDLE_LIGHT_SCHEDULER_HPP__
+
+#include <unordered_map>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Object to cast lights within a time budget per frame.
+     * @details
+     *
+     * When many lights change at once, casting all of them in the same
+     * frame may take too long. A LightScheduler keeps the lights pending to
+     * be casted and, in each call to @ref update, casts as many as fit in
+     * the given time budget. The rest are carried over to the next frames,
+     * and meanwhile they keep drawing the polygon of their last cast.
+     *
+     * Pending lights are casted in order of priority, which is computed
+     * from three criteria, weighted with @ref setWeights:
+     *   - Size: the fraction of the view covered by the light.
+     *   - Distance: how close the light is to the center of the view.
+     *   - Staleness: the number of frames the light has been waiting.
+     *
+     * At least one light is casted in each update, so the scheduler always
+     * progresses even if the budget is too small.
+     */
+    class LightScheduler{
+    private:
+        struct Entry{
+            LightSource* light;
+            unsigned int frames;
+            float priority;
+        };
+        std::vector<Entry> m_pending;
+        std::unordered_map<const LightSource*, size_t> m_index; // position in m_pending
+        sf::FloatRect m_viewBounds;
+        float m_sizeWeight;
+        float m_distanceWeight;
+        float m_stalenessWeight;
+        sf::Time m_averageCost;
+        bool m_costMeasured;
+
+        float computePriority(const Entry& entry) const;
+
+    public:
+        /**
+         * @brief Constructor.
+         */
+        LightScheduler();
+
+        /**
+         * @brief Set the view used to compute the priorities.
+         * @param view
+         */
+        void setCamera(const sf::View& view);
+
+        /**
+         * @brief Set the weights of the criteria to compute the priorities.
+         * @details The default values are 1 for size, 1 for distance and
+         * 0.1 for staleness.
+         * @param size Weight of the fraction of the view covered by a light.
+         * @param distance Weight of the proximity to the center of the view.
+         * @param staleness Weight of each frame a light has been waiting.
+         */
+        void setWeights(float size, float distance, float staleness);
+
+        /**
+         * @brief Add a light to the pending ones.
+         * @details If it is already pending, it keeps its staleness. The
+         * light must exist until it is casted or unscheduled.
+         * @param light
+         */
+        void schedule(LightSource& light);
+
+        /**
+         * @brief Remove a light from the pending ones.
+         * @param light
+         */
+        void unschedule(const LightSource& light);
+
+        /**
+         * @brief Get the number of pending lights.
+         * @returns The number of pending lights.
+         */
+        size_t getPendingCount() const;
+
+        /**
+         * @brief Get the average time spent to cast a light.
+         * @details Until the first cast, nothing has been measured and it
+         * returns zero.
+         * @returns The average time measured in previous updates.
+         */
+        sf::Time getAverageCastTime() const;
+
+        /**
+         * @brief Cast pending lights until the budget is spent.
+         * @details A light is not started if the time already spent plus
+         * the average cast time exceeds @p budget. Before any cast has been
+         * measured, the first cast of the update is used as the average.
+         * @param begin Iterator to the first edge.
+         * @param end Iterator to the first edge not to be taken into account.
+         * @param budget Time available for this frame.
+         * @returns The number of lights casted.
+         */
+        size_t update(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::Time budget);
+    };
+}
+
+#endif
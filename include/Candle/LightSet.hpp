@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightSet class.
+ */
+#ifndef __CANDLE_LIGHT_SET_HPP__
+#define __CANDLE_LIGHT_SET_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Group of lights casted once and drawn to several areas.
+     * @details
+     *
+     * With split-screen, a minimap or several layers, the same lights are
+     * drawn to more than one LightingArea. The polygon of a light is in
+     * world coordinates and each area applies its own transform when the
+     * light is drawn, so there is no need to cast it again per area.
+     *
+     * A LightSet casts its lights once per frame with @ref castLights and
+     * stores their bounds. Then it can be drawn to any number of areas
+     * with LightingArea::draw(const LightSet&), that culls the lights with
+     * the stored bounds against the area (and, optionally, a view) at that
+     * moment.
+     *
+     * The lights are not copied, so they must outlive the set or be
+     * removed from it first.
+     */
+    class LightSet{
+    private:
+        friend class LightingArea;
+
+        std::vector<LightSource*> m_lights;
+        std::vector<sf::FloatRect> m_bounds;
+
+    public:
+        /**
+         * @brief Add a light to the set.
+         * @param light
+         */
+        void add(LightSource& light);
+
+        /**
+         * @brief Remove a light from the set.
+         * @param light
+         * @returns True if the light was in the set.
+         */
+        bool remove(const LightSource& light);
+
+        /**
+         * @brief Remove all the lights.
+         */
+        void clear();
+
+        /**
+         * @brief Get the number of lights in the set.
+         */
+        size_t getLightCount() const;
+
+        /**
+         * @brief Cast all the lights and store their bounds.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @returns The number of lights casted.
+         */
+        unsigned int castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+
+        /**
+         * @brief Cast only the lights that reach some region.
+         * @details Pass the bounds of all the areas or views the set will
+         * be drawn to (see getViewBounds, LightingArea::getGlobalBounds), so
+         * each light is casted once if it is seen by any of them, and not at
+         * all otherwise. The lights that are not casted keep their previous
+         * polygon, but they are culled in every area.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param regions Rectangles in global coordinates.
+         * @returns The number of lights casted.
+         */
+        unsigned int castLights(const EdgeVector::iterator& begin,
+                                const EdgeVector::iterator& end,
+                                const std::vector<sf::FloatRect>& regions);
+    };
+}
+
+#endif
@@ -8,11 +8,15 @@
 #ifndef __CANDLE_LIGHTSOURCE_HPP__
 #define __CANDLE_LIGHTSOURCE_HPP__
 
+#include <future>
+#include <typeinfo>
 #include <vector>
 
 #include "SFML/Graphics.hpp"
 
 #include "Candle/geometry/Line.hpp"
+#include "Candle/geometry/Capsule.hpp"
+#include "Candle/graphics/SoftwareTarget.hpp"
 
 namespace candle{
     /**
@@ -27,13 +31,22 @@ namespace candle{
      */
     typedef std::vector<Edge> EdgeVector;
     
+    /**
+     * @typedef CapsuleVector
+     * @brief Typedef to shorten the use of vectors as round occluder pools
+     */
+    typedef std::vector<sfu::Capsule> CapsuleVector;
+    
     /**
      * @brief This function initializes the Texture used for the RadialLights.
-     * @details This function is called the first time a RadialLight is created
+     * @details This function is called the first time a RadialLight is drawn
      * , so the user shouldn't need to do it. Anyways, it could be 
      * necessary to do it explicitly if you declare a RadialLight that, for 
      * some reason, is global or static RadialLight and is not constructed in
      * a normal order.
+     * 
+     * As it requires an OpenGL context, it is never called when lights are
+     * only drawn to a LightingArea with the SOFTWARE backend.
      */
     void initializeTextures();
     
@@ -57,10 +70,29 @@ namespace candle{
      */
     class LightSource: public sf::Transformable, public sf::Drawable{
     private:
+        friend class LightingArea;
+        friend class LightPool;
+        friend class VisibilityCache;
+        friend class OccluderGroup;
+        
         /**
          * @brief Draw the object to a target
          */
         virtual void draw(sf::RenderTarget& t, sf::RenderStates st) const = 0;
+        
+        /**
+         * @brief Draw the object to a software target.
+         * @details The default implementation draws nothing.
+         */
+        virtual void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+  
+        sf::VertexArray m_backPolygon;
+        std::shared_future<void> m_pendingCast;
+        const std::type_info* m_asyncType;
+        bool m_legacyCast;
+#ifdef CANDLE_DEBUG
+        sf::VertexArray m_backDebug;
+#endif
   
     protected:
         sf::Color m_color;
@@ -72,8 +104,75 @@ namespace candle{
 #ifdef CANDLE_DEBUG        
         sf::VertexArray m_debug;
 #endif
+
+#ifdef CANDLE_DEBUG
+        /**
+         * @brief Get the debug lines that go with a polygon.
+         * @details The back buffer of @ref castLightAsync has its own debug
+         * lines, swapped by @ref swapPolygon, so the worker doesn't write
+         * the ones being drawn.
+         * @param polygon Output polygon of @ref castPolygon.
+         */
+        sf::VertexArray& getDebugLines(const sf::VertexArray& polygon);
+#endif
         
         virtual void resetColor() = 0;
+        
+        /**
+         * @brief Compute the polygon of the illuminated area with a
+         * raycasting algorithm.
+         * @details This is the algorithm used by @ref castLight and
+         * @ref castLightAsync, so it must not write to any member but
+         * @p polygon (and the debug lines given by getDebugLines).
+         * 
+         * The default implementation is for the subclasses that override
+         * @ref castLight instead, as they had to before this method
+         * existed: it calls @ref castLight and copies the result to
+         * @p polygon. Those subclasses are never casted in another thread
+         * by @ref castLightAsync.
+         * @param begin Iterator to the first sfu::Line of the vector to take 
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param polygon (Output argument) Polygon of the illuminated area.
+         */
+        virtual void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon);
+        
+        /**
+         * @brief Compute the polygon of the illuminated area, with round
+         * occluders too.
+         * @details The default implementation ignores the capsules.
+         * @param begin Iterator to the first sfu::Line of the vector to take 
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param capsulesBegin Iterator to the first sfu::Capsule to take
+         * into account.
+         * @param capsulesEnd Iterator to the first sfu::Capsule not to be
+         * taken into account.
+         * @param polygon (Output argument) Polygon of the illuminated area.
+         */
+        virtual void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                 const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                                 sf::VertexArray& polygon);
+        
+        /**
+         * @brief Wait for the pending asynchronous cast, if any.
+         */
+        void waitForCast();
+        
+        /**
+         * @brief Allow the lights of a class to be casted in another thread
+         * by @ref castLightAsync.
+         * @details The worker thread runs @ref castPolygon, so the class
+         * must call @ref waitForCast in its destructor, before any of its
+         * members is destroyed. It only applies to the lights whose most
+         * derived class is exactly @p type, so a subclass that doesn't
+         * allow it (and may not wait in its destructor) is casted in the
+         * calling thread instead.
+         * @param type Type of the class, as given by typeid.
+         */
+        void allowAsyncCast(const std::type_info& type);
     
     public:
         /**
@@ -81,6 +180,12 @@ namespace candle{
          */
         LightSource();
         
+        /**
+         * @brief Destructor
+         * @details Waits for the pending asynchronous cast, if any.
+         */
+        virtual ~LightSource();
+        
          /**
          * @brief Set the light intensity.
          * @details The @p intensity of the light determines two things: 
@@ -157,19 +262,110 @@ namespace candle{
          */
         float getRange() const;
         
+        /**
+         * @brief Get the local bounding rectangle of the light.
+         * @details The default implementation returns the square of half
+         * side @ref getRange centered in the local origin, which bounds any
+         * light that doesn't reach further than its range.
+         * @returns The local bounding rectangle in float.
+         */
+        virtual sf::FloatRect getLocalBounds() const;
+        
+        /**
+         * @brief Get the global bounding rectangle of the light.
+         * @details It bounds the area that the light may illuminate, with
+         * the transformation already applied. The default implementation
+         * transforms @ref getLocalBounds.
+         * @returns The global bounding rectangle in float.
+         */
+        virtual sf::FloatRect getGlobalBounds() const;
+        
+        /**
+         * @brief Get how much a point is illuminated by the light.
+         * @details The point is tested against the last polygon casted, with
+         * the same falloff used to draw the light, so it answers on the CPU
+         * what would be read from a LightingArea. The default implementation
+         * returns 0.
+         * @param point Point in global coordinates.
+         * @returns The intensity of the light at @p point, from 0 (not
+         * illuminated) to @ref getIntensity.
+         * @see LightSampler
+         */
+        virtual float getIllumination(const sf::Vector2f& point) const;
+        
         /**
          * @brief Modify the polygon of the illuminated area with a 
          * raycasting algorithm.
          * @details The algorithm needs to know which edges to use to cast 
          * shadows. They are specified within a range of two iterators of a
          * vector of edges of type @ref sfu::Line.
+         * 
+         * The default implementation uses @ref castPolygon. Subclasses should
+         * override @ref castPolygon rather than this method, so they can
+         * also be casted with @ref castLightAsync.
          * @param begin Iterator to the first sfu::Line of the vector to take 
          * into account.
          * @param end Iterator to the first sfu::Line of the vector not to be
          * taken into account.
          * @see setRange, [EdgeVector](@ref LightSource.hpp)
          */
-        virtual void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end) = 0;
+        virtual void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+        
+        /**
+         * @brief Modify the polygon of the illuminated area, with round
+         * occluders too.
+         * @details Circles and capsules are tested analytically and only add
+         * the rays next to the two tangents of their silhouette, so they are
+         * much cheaper than tessellating them into edges.
+         * @param begin Iterator to the first sfu::Line of the vector to take 
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param capsulesBegin Iterator to the first sfu::Capsule to take
+         * into account.
+         * @param capsulesEnd Iterator to the first sfu::Capsule not to be
+         * taken into account.
+         * @see castLight(const EdgeVector::iterator&, const EdgeVector::iterator&)
+         */
+        void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                       const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd);
+        
+        /**
+         * @brief Cast the light in another thread.
+         * @details The polygon is computed into a back buffer, so the light
+         * can still be drawn with the result of the previous cast while the
+         * new one is computed. The result is only used after a call to
+         * @ref swapPolygon.
+         * 
+         * Until the cast completes, neither the light nor the edges in the
+         * range can be modified. If there is already a pending cast, it is
+         * waited for first.
+         * 
+         * Only the classes that call @ref allowAsyncCast, like RadialLight
+         * and DirectedLight, are casted in another thread. Lights of other
+         * classes, including subclasses of those, are casted in the calling
+         * thread before returning, as destroying them during the cast would
+         * run a method of an object already destroyed. The result is still
+         * kept in the back buffer until @ref swapPolygon.
+         * @param begin Iterator to the first sfu::Line of the vector to take 
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param policy Launch policy of the cast.
+         * @returns Future that becomes ready when the cast is complete.
+         * @see swapPolygon
+         */
+        std::shared_future<void> castLightAsync(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, std::launch policy=std::launch::async);
+        
+        /**
+         * @brief Use the result of the last asynchronous cast.
+         * @details If the cast is not complete, it is waited for. Call it
+         * at the synchronization point of your frame, when the light is not
+         * being drawn.
+         * @returns True if there was a cast to swap in.
+         * @see castLightAsync
+         */
+        bool swapPolygon();
     };
 }
 
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the LightTree class.
+ */
+#ifndef __CANDLE_LIGHT_TREE_HPP__
+#define __CANDLE_LIGHT_TREE_HPP__
+
+#include <unordered_map>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Spatial index of lights by their global bounds.
+     * @details
+     *
+     * A LightTree is a dynamic bounding volume tree: each light is a leaf
+     * with its bounds enlarged by a margin, and each inner node bounds its
+     * two children. It answers which lights may reach a region or a point
+     * without looping over all of them, for example:
+     *   - To cull the lights out of the view (see cullLights).
+     *   - To select the lights to sample at some points (see LightSampler).
+     *   - To find the lights to recast when the edges of a region change.
+     *
+     * The lights are not copied. Call @ref update once per frame, after
+     * moving, rotating or changing the range of the lights: it checks the
+     * bounds of every light and only moves in the tree the ones that left
+     * their enlarged bounds. A light must be removed before it is
+     * destroyed.
+     */
+    class LightTree{
+    private:
+        struct Node{
+            sf::FloatRect box;
+            sf::FloatRect bounds;
+            LightSource* light;
+            int parent;
+            int left;
+            int right;
+            int height;
+        };
+        std::vector<Node> m_nodes;
+        std::vector<int> m_freeNodes;
+        std::unordered_map<const LightSource*, int> m_leaves;
+        int m_root;
+        float m_margin;
+
+        int allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int node);
+        void refit(int node);
+        void setLeafBounds(int leaf);
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param margin Distance by which the bounds of the lights are
+         * enlarged in the tree. Lights that move less than it in a frame
+         * don't need to be moved in the tree.
+         */
+        explicit LightTree(float margin=16.f);
+
+        /**
+         * @brief Add a light to the tree.
+         * @details If the light is already in the tree, it is updated.
+         * @param light
+         */
+        void insert(LightSource& light);
+
+        /**
+         * @brief Remove a light from the tree.
+         * @param light
+         * @returns True if the light was in the tree.
+         */
+        bool remove(const LightSource& light);
+
+        /**
+         * @brief Remove all the lights.
+         */
+        void clear();
+
+        /**
+         * @brief Check if a light is in the tree.
+         * @param light
+         */
+        bool contains(const LightSource& light) const;
+
+        /**
+         * @brief Get the number of lights in the tree.
+         */
+        size_t getLightCount() const;
+
+        /**
+         * @brief Update the bounds of all the lights.
+         * @returns The number of lights that were moved in the tree.
+         */
+        unsigned int update();
+
+        /**
+         * @brief Update the bounds of a single light.
+         * @param light
+         */
+        void update(const LightSource& light);
+
+        /**
+         * @brief Get the lights whose bounds intersect a region.
+         * @details The bounds are the ones of the last update. The lights
+         * found are appended to @p lights.
+         * @param region Rectangle in global coordinates.
+         * @param lights (Output argument)
+         */
+        void query(const sf::FloatRect& region, std::vector<LightSource*>& lights) const;
+
+        /**
+         * @brief Get the lights whose bounds contain a point.
+         * @details The bounds are the ones of the last update. The lights
+         * found are appended to @p lights.
+         * @param point Point in global coordinates.
+         * @param lights (Output argument)
+         */
+        void query(const sf::Vector2f& point, std::vector<LightSource*>& lights) const;
+    };
+}
+
+#endif
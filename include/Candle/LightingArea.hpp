@@ -8,11 +8,20 @@
 #define __CANDLE_LIGHTING_HPP__
 
 #include <set>
+#include <vector>
 
 #include "SFML/Graphics.hpp"
 
 #include "Candle/geometry/Line.hpp"
+#include "Candle/graphics/SoftwareTarget.hpp"
+#include "Candle/Culling.hpp"
 #include "Candle/LightSource.hpp"
+#include "Candle/LightPool.hpp"
+#include "Candle/LightParticles.hpp"
+#include "Candle/VisionMask.hpp"
+#include "Candle/ExploredMask.hpp"
+#include "Candle/LightSet.hpp"
+#include "Candle/OccluderGroup.hpp"
 
 namespace candle{
     /**
@@ -58,6 +67,26 @@ namespace candle{
      * modified. So, if you want to change the texture and the size, you must
      * change the texture first and scale it after that.
      * 
+     * The area can also be constructed with the SOFTWARE
+     * [backend](@ref LightingArea::Backend). Then, the lights are rasterized
+     * on the CPU into a float buffer instead of a sf::RenderTexture, so it
+     * can be used without an OpenGL context (e.g. in a server) and its
+     * result can be read with @ref copyToImage without stalling the GPU.
+     * Its base texture can be given as a sf::Image with @ref setAreaImage,
+     * as getting the pixels of a sf::Texture requires a context too.
+     * 
+     * In FOG mode, lights that don't change often can be registered as
+     * static lights with @ref addStaticLight. They are drawn once to a
+     * persistent layer that is copied in each call to @ref clear, so only
+     * the dynamic lights have to be drawn every frame. The layer is redrawn
+     * in the next call to @ref clear after it is invalidated, which happens
+     * automatically when the area or the set of static lights change. The
+     * area doesn't track the lights nor the edges: when a static light is
+     * modified or recasted, or the edges near it change, the layer must be
+     * invalidated manually with @ref invalidateStaticLayer. In AMBIENT mode
+     * the static lights are kept registered but ignored, as lights are not
+     * drawn to the area in that mode.
+     * 
      */
     class LightingArea: public sf::Transformable, public sf::Drawable{
     public:
@@ -76,22 +105,54 @@ namespace candle{
              */
             AMBIENT
         };
+        
+        /**
+         * @brief Rendering backends for a LightingArea.
+         * @see getBackend
+         */
+        enum Backend {
+            /**
+             * Render with OpenGL, to a sf::RenderTexture.
+             */
+            HARDWARE,
+            /**
+             * Rasterize on the CPU, to a sfu::SoftwareTarget. No OpenGL
+             * context is needed, unless the area is drawn to a
+             * sf::RenderTarget or has a base texture.
+             */
+            SOFTWARE
+        };
     private:
         const sf::Texture* m_baseTexture;
+        sf::Image m_baseImage;
         sf::IntRect m_baseTextureRect;
         sf::VertexArray m_baseTextureQuad;
         sf::RenderTexture m_renderTexture;
+        sfu::SoftwareTarget m_softwareTarget;
+        mutable sf::Texture m_softwareTexture;
+        mutable bool m_softwareTextureOutdated;
+        Backend m_backend;
         sf::VertexArray m_areaQuad;
         sf::Color m_color;
         float m_opacity;
+        float m_resolutionScale;
         sf::Vector2f m_size;
         Mode m_mode;
+        std::vector<const LightSource*> m_staticLights;
+        sf::Texture m_staticLayer;
+        sfu::SoftwareTarget m_staticSoftwareLayer;
+        sf::Transform m_staticLayerTransform;
+        bool m_staticLayerOutdated;
         /**
          * @brief Draw the object to the target.
          */
         void draw(sf::RenderTarget&, sf::RenderStates)const override;
         sf::Color getActualColor() const;
         void initializeRenderTexture(const sf::Vector2f& size);
+        void clearBase();
+        void updateStaticLayer();
+        sf::RenderStates getFogStates() const;
+        void drawCulled(const LightSet& set, const sf::FloatRect& region);
     public:
         
         /**
@@ -101,8 +162,9 @@ namespace candle{
          * @param mode
          * @param position
          * @param size
+         * @param backend
          */
-        LightingArea(Mode mode, const sf::Vector2f& position, const sf::Vector2f& size);
+        LightingArea(Mode mode, const sf::Vector2f& position, const sf::Vector2f& size, Backend backend=HARDWARE);
         
         /**
          * @brief Constructor.
@@ -112,8 +174,17 @@ namespace candle{
          * @param mode
          * @param texture
          * @param rect
+         * @param backend
          */
-        LightingArea(Mode mode, const sf::Texture* texture, sf::IntRect rect=sf::IntRect());
+        LightingArea(Mode mode, const sf::Texture* texture, sf::IntRect rect=sf::IntRect(), Backend backend=HARDWARE);
+        
+        /**
+         * @brief Get the rendering backend.
+         * @details The backend can only be specified upon construction.
+         * @returns The rendering backend.
+         * @see LightingArea::Backend
+         */
+        Backend getBackend() const;
         
         /**
          * @brief Get the local bounding rectangle of the area.
@@ -177,6 +248,50 @@ namespace candle{
          */
         void setAreaTexture(const sf::Texture* texture, sf::IntRect rect=sf::IntRect());
         
+        /**
+         * @brief Set the texture of the fog/light from an image.
+         * @details Only for the SOFTWARE backend, where the base texture is
+         * sampled from an image: unlike @ref setAreaTexture, it doesn't need
+         * an OpenGL context, so a headless area can start, for example, from
+         * a light map read with @ref loadLightMap. The image is copied. With
+         * the GPU backend it does nothing.
+         * 
+         * As with @ref setAreaTexture, the area is created again to match
+         * the size of @p rect, and @ref getAreaTexture returns a null pointer
+         * afterwards.
+         * @param image New texture. Pass an empty image to just unset the
+         * texture.
+         * @param rect Optional rectangle to call @ref setTextureRect. If none 
+         * is specified, the whole image is used.
+         * @see setAreaTexture
+         */
+        void setAreaImage(const sf::Image& image, sf::IntRect rect=sf::IntRect());
+        
+        /**
+         * @brief Set the resolution of the area relative to its size.
+         * @details Lighting is usually low-frequency, so it can be rendered
+         * to a smaller texture, which is upsampled with bilinear filtering
+         * when the area is drawn. For example, with a scale of 0.5 the
+         * sf::RenderTexture has half the width and half the height of the
+         * area, a quarter of the pixels to fill.
+         * 
+         * As with @ref setAreaTexture, this creates the sf::RenderTexture
+         * again.
+         * 
+         * The default value is 1. Values greater than 1 are clamped to 1,
+         * and values not greater than 0 are ignored.
+         * @param scale Value from 0 (exclusive) to 1.
+         * @see getResolutionScale
+         */
+        void setResolutionScale(float scale);
+        
+        /**
+         * @brief Get the resolution of the area relative to its size.
+         * @returns The resolution scale.
+         * @see setResolutionScale
+         */
+        float getResolutionScale() const;
+        
         /**
          * @brief Get the texture of the fog/light.
          * @returns Pointer to the texture of the fog/light.
@@ -216,24 +331,164 @@ namespace candle{
         
         /**
          * @brief Updates and restores the color and the texture.
-         * @details In FOG mode, it restores the covered areas.
+         * @details In FOG mode, it restores the covered areas. If there are
+         * static lights, the area is restored to the static layer instead,
+         * which is redrawn first if it has been invalidated. In AMBIENT mode
+         * the static layer is not used.
          */
         void clear();
         
+        /**
+         * @brief Register a light to be drawn in the static layer.
+         * @details The light must exist and be managed externally while it
+         * is registered. It must be already casted, as the area only draws
+         * it. The static layer is only used in FOG mode; in AMBIENT mode the
+         * light stays registered but it has no effect.
+         * @param light
+         * @see removeStaticLight, invalidateStaticLayer
+         */
+        void addStaticLight(const LightSource& light);
+        
+        /**
+         * @brief Unregister a light from the static layer.
+         * @param light
+         * @see addStaticLight
+         */
+        void removeStaticLight(const LightSource& light);
+        
+        /**
+         * @brief Force the static layer to be redrawn in the next call to
+         * @ref clear.
+         * @details Invalidation is manual: call it after modifying or
+         * recasting a static light, or when the edges near it change. Only
+         * changes to the area itself, including its transform, and to the
+         * set of static lights invalidate the layer automatically.
+         */
+        void invalidateStaticLayer();
+        
+        /**
+         * @brief Invalidate the static layer only if a region affects it.
+         * @details Use it when edges change: the layer is invalidated only
+         * if @p region intersects the global bounds of a static light.
+         * @param region Region that changed, in global coordinates.
+         * @returns True if the static layer has been invalidated.
+         */
+        bool invalidateStaticLayer(const sf::FloatRect& region);
+        
         /**
          * @brief In FOG mode, makes visible the area illuminated by the light.
          * @details In FOG mode with opacity greater than zero, this function.
          * is necessary to keep the lighting coherent. In AMBIENT mode, this
-         * function has no effect. 
+         * function has no effect. Lights that are HIDDEN from the area are
+         * skipped.
          * @param light
          */
         void draw(const LightSource& light);
         
+        /**
+         * @brief In FOG mode, makes visible the area illuminated by all the
+         * lights of a pool.
+         * @details It is the same as drawing each light of the pool, but in
+         * one draw call per kind of light.
+         * @param pool
+         * @see draw(const LightSource&)
+         */
+        void draw(const LightPool& pool);
+        
+        /**
+         * @brief In FOG mode, makes visible the area illuminated by a set of
+         * light particles.
+         * @param particles
+         * @see draw(const LightSource&)
+         */
+        void draw(const LightParticles& particles);
+        
+        /**
+         * @brief In FOG mode, makes visible the area seen by a group of
+         * viewpoints.
+         * @details The whole group is drawn as a single quad.
+         * @param mask
+         * @see draw(const LightSource&)
+         */
+        void draw(const VisionMask& mask);
+        
+        /**
+         * @brief In FOG mode, partially reveals the explored areas.
+         * @details Draw it right after @ref clear, so the current vision is
+         * drawn over it.
+         * @param explored
+         * @see ExploredMask::setOpacity
+         */
+        void draw(const ExploredMask& explored);
+        
+        /**
+         * @brief In FOG mode, makes visible the area illuminated by the
+         * lights of a set.
+         * @details The lights are culled against the area with the bounds
+         * stored in their last cast (see LightSet::castLights), so the same
+         * set can be drawn to many areas without casting it again.
+         * @param set
+         * @see draw(const LightSource&)
+         */
+        void draw(const LightSet& set);
+        
+        /**
+         * @brief In FOG mode, makes visible the area illuminated by the
+         * lights of a set that can be seen through a view.
+         * @details The lights are culled against the part of the area seen
+         * through @p view.
+         * @param set
+         * @param view
+         * @see draw(const LightSet&)
+         */
+        void draw(const LightSet& set, const sf::View& view);
+        
+        /**
+         * @brief In FOG mode, makes visible the area illuminated by the
+         * lights attached to a group.
+         * @details The transform of the group is applied to the polygons
+         * casted in its local space (see OccluderGroup::castLights).
+         * @param group
+         * @see draw(const LightSource&)
+         */
+        void draw(const OccluderGroup& group);
+        
+        /**
+         * @brief Test if a light may illuminate the area.
+         * @details Use it to skip casting lights that wouldn't have any
+         * effect.
+         * @param light
+         * @returns The visibility of the light in the global bounds of the
+         * area.
+         * @see testVisibility
+         */
+        Visibility cull(const LightSource& light) const;
+        
+        /**
+         * @brief Test if a light may illuminate the part of the area seen
+         * through a view.
+         * @param light
+         * @param view
+         * @returns The visibility of the light in the intersection of the
+         * global bounds of the area and the bounds of the view.
+         * @see testVisibility, getViewBounds
+         */
+        Visibility cull(const LightSource& light, const sf::View& view) const;
+        
         /**
          * @brief Calls display on the sf::RenderTexture.
          * @details Updates the changes made since the last call to @ref clear.
          */
         void display();
+        
+        /**
+         * @brief Copy the content of the area to an image.
+         * @details With the HARDWARE backend, this reads back the texture
+         * from the GPU. With the SOFTWARE backend, it only quantizes the CPU
+         * buffer.
+         * @returns Image with the content of the area.
+         */
+        sf::Image copyToImage() const;
     };
 }
 
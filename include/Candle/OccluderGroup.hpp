@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the OccluderGroup class.
+ */
+#ifndef __CANDLE_OCCLUDER_GROUP_HPP__
+#define __CANDLE_OCCLUDER_GROUP_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Rigid group of edges and lights that move together.
+     * @details
+     *
+     * A vehicle with headlights carries its own hull edges, and all of
+     * them move every frame. Casting the headlights in world space would
+     * make them recast every frame, even if the shadows, seen from the
+     * vehicle, don't change.
+     *
+     * An OccluderGroup is a Transformable with edges and lights in its own
+     * local space: the transform of each attached light is relative to the
+     * group. The lights are casted in local space against the edges of the
+     * group and the world edges inside their bounds (transformed to local
+     * space), and their polygons are kept there. When the group is drawn,
+     * its transform is applied to the polygons, so moving the group does
+     * not need a recast.
+     *
+     * A light is casted again by @ref castLights only if:
+     * - The world edges inside its bounds changed, seen from the group
+     * (an edge was added or removed, or the group moved relative to it).
+     * - Its transform or range changed.
+     * - The edges of the group changed.
+     * - It was invalidated with @ref invalidate (for example, after
+     * changing its beam angle).
+     *
+     * The edges of the group should not be passed again in the world edges
+     * given to @ref castLights; otherwise they would move with the group and
+     * the lights would be casted every frame. Use @ref getGlobalEdges to
+     * add them to the edges of the lights that are not in the group.
+     *
+     * The lights are not copied, so they must outlive the group or be
+     * detached first.
+     */
+    class OccluderGroup: public sf::Transformable, public sf::Drawable{
+    private:
+        friend class LightingArea;
+
+        struct Attachment{
+            LightSource* light;
+            EdgeVector seen; // world edges inside the bounds, in local space
+            float matrix[16];
+            float range;
+            bool dirty;
+        };
+
+        EdgeVector m_edges;
+        EdgeVector m_castEdges;
+        EdgeVector m_seen;
+        std::vector<Attachment> m_lights;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+
+    public:
+        /**
+         * @brief Add an edge to the group.
+         * @param edge Edge in the local space of the group.
+         */
+        void addEdge(const sfu::Line& edge);
+
+        /**
+         * @brief Remove all the edges of the group.
+         */
+        void clearEdges();
+
+        /**
+         * @brief Get the edges of the group, in local space.
+         */
+        const EdgeVector& getEdges() const;
+
+        /**
+         * @brief Append the edges of the group, in global space, to a
+         * vector.
+         * @param edges
+         */
+        void getGlobalEdges(EdgeVector& edges) const;
+
+        /**
+         * @brief Attach a light to the group.
+         * @details From now on, the transform of the light is relative to
+         * the group.
+         * @param light
+         */
+        void attach(LightSource& light);
+
+        /**
+         * @brief Detach a light from the group.
+         * @param light
+         * @returns True if the light was attached to the group.
+         */
+        bool detach(const LightSource& light);
+
+        /**
+         * @brief Get the number of lights attached.
+         */
+        size_t getLightCount() const;
+
+        /**
+         * @brief Force all the lights to be casted in the next call to
+         * @ref castLights.
+         */
+        void invalidate();
+
+        /**
+         * @brief Force a light to be casted in the next call to
+         * @ref castLights.
+         * @param light
+         */
+        void invalidate(const LightSource& light);
+
+        /**
+         * @brief Cast the lights whose surroundings changed.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @returns The number of lights casted.
+         */
+        unsigned int castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+    };
+}
+
+#endif
@@ -31,11 +31,35 @@ namespace candle{
      */
     class RadialLight: public LightSource{
     private:
+        friend class LightPool;
+        friend class LightParticles;
+
         static int s_instanceCount;
         float m_beamAngle;
+        unsigned int m_sectors;
+        bool m_exactCasting;
 
         void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const override;
         void resetColor() override;
+        sf::Transform getPolygonTransform() const;
+        static const sf::Texture* getLightTexture(bool fade);
+        static sfu::SoftwareTarget::TextureFunction getLightTextureFunction(bool fade);
+        static sf::FloatRect getLightTextureRect();
+        void castArc(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                     const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                     float bl1, float bl2, bool fullCircle, sf::VertexArray& polygon);
+        template <typename Beam>
+        void castKernel(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                        const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                        const Beam& beam, sf::VertexArray& polygon);
+        void castExact(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon);
+
+    protected:
+        void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon) override;
+        void castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                         const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                         sf::VertexArray& polygon) override;
 
     public:
         /**
@@ -48,7 +72,26 @@ namespace candle{
          */
         virtual ~RadialLight();
 
-        void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end) override;
+        using LightSource::castLight;
+
+        /**
+         * @brief Cast the light only in the directions that reach a
+         * rectangle.
+         * @details Rays are only generated within the angular interval that
+         * @p clip subtends from the position of the light (intersected with
+         * the beam), so the resulting polygon is a partial fan that is exact
+         * inside @p clip. If the light is inside @p clip, it is the same as
+         * @ref castLight(const EdgeVector::iterator&, const EdgeVector::iterator&).
+         * 
+         * It is meant to be used with the bounds of the view (see
+         * getViewBounds) for big lights that are mostly off-screen.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @param clip Rectangle in global coordinates.
+         */
+        void castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, const sf::FloatRect& clip);
 
         /**
          * @brief Set the range for which rays may be casted.
@@ -64,19 +107,77 @@ namespace candle{
          * @details It defaults to 360º.
          * @see setBeamAngle
          */
-        float getBeamAngle() const;
-
-        /**
-         * @brief Get the local bounding rectangle of the light.
-         * @returns The local bounding rectangle in float.
-         */
-        sf::FloatRect getLocalBounds() const;
-
-        /**
-         * @brief Get the global bounding rectangle of the light.
-         * @returns The global bounding rectangle in float.
-         */
-        sf::FloatRect getGlobalBounds() const;
+        float getBeamAngle() const;
+
+        /**
+         * @brief Set the number of sectors in which the rays are casted in
+         * parallel.
+         * @details The rays of a cast are sorted by angle and split into
+         * @p sectors contiguous ranges, each one casted in its own thread.
+         * The resulting polygon is the same as with a single sector. It is
+         * meant for huge lights with many edges in range, where a single
+         * cast takes more than a frame; lights with few rays are not split.
+         * @param sectors Number of sectors. 0 is treated as 1.
+         * @see getSectorCount
+         */
+        void setSectorCount(unsigned int sectors);
+
+        /**
+         * @brief Get the number of sectors in which the rays are casted.
+         * @details It defaults to 1, that is, no parallelism.
+         * @see setSectorCount
+         */
+        unsigned int getSectorCount() const;
+
+        /**
+         * @brief Set if the light is casted with exact predicates.
+         * @details When enabled, the polygon is built as the visibility
+         * polygon of sfu::castVisibility: a single ray per end of edge, with
+         * the hits at each side computed exactly, instead of three rays
+         * with angular offsets in float. If the position of the light and
+         * the ends of the edges in range are integers (for example, edges of
+         * a tile grid and a light snapped to pixels) the predicates are
+         * evaluated with integers, so the polygon doesn't flicker and is the
+         * same in every machine; otherwise they are evaluated in double.
+         * 
+         * It only applies to full circle lights without round occluders;
+         * lights with a beam angle, the capsules and the partial casts of
+         * @ref castLight with a clip rectangle use the rays. The area
+         * reached is the square that contains the circle of the range, like
+         * the fan of the rays.
+         * @param exact
+         * @see getExactCasting
+         */
+        void setExactCasting(bool exact);
+
+        /**
+         * @brief Check if the light is casted with exact predicates.
+         * @details It defaults to false.
+         * @see setExactCasting
+         */
+        bool getExactCasting() const;
+
+        /**
+         * @brief Get the local bounding rectangle of the light.
+         * @returns The local bounding rectangle in float.
+         */
+        sf::FloatRect getLocalBounds() const override;
+
+        /**
+         * @brief Get the global bounding rectangle of the light.
+         * @returns The global bounding rectangle in float.
+         */
+        sf::FloatRect getGlobalBounds() const override;
+
+        /**
+         * @brief Get how much a point is illuminated by the light.
+         * @details The point is located in the fan of the polygon with a
+         * binary search by angle, so it is logarithmic in the number of
+         * rays.
+         * @param point Point in global coordinates.
+         * @returns The intensity of the light at @p point.
+         */
+        float getIllumination(const sf::Vector2f& point) const override;
 
     };
 }
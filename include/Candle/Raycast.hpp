@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the EdgeGrid class, to answer raycast and line
+ * of sight queries in batch.
+ */
+#ifndef __CANDLE_RAYCAST_HPP__
+#define __CANDLE_RAYCAST_HPP__
+
+#include <vector>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "Candle/geometry/Line.hpp"
+
+namespace candle{
+    /**
+     * @brief Result of a raycast query.
+     * @see EdgeGrid::castRay
+     */
+    struct RayHit{
+        bool hit; ///< True if the ray hit an edge.
+        unsigned int edge; ///< Index of the edge hit, if any.
+        float distance; ///< Distance from the origin of the ray to the hit.
+        sf::Vector2f normal; ///< Unit normal of the edge, facing the ray.
+    };
+
+    /**
+     * @brief Uniform grid over a set of edges, to cast many rays against
+     * them.
+     * @details The grid is built once from the same edges used to cast the
+     * lights (for example, the ones of an EdgeVector) and then it can be
+     * queried from several threads at the same time. Each ray only tests the
+     * edges of the cells it crosses, in order, and stops at the first cell
+     * with a hit.
+     *
+     * The queries are segments: a ray starts at its
+     * [origin](@ref sfu::Line::m_origin) and reaches, at most,
+     * [point(1)](@ref sfu::Line::point). An edge parallel to a ray doesn't
+     * block it.
+     *
+     * It is part of the Candle-core library, so it can be used without a
+     * graphics context.
+     */
+    class EdgeGrid{
+    private:
+        sf::Vector2f m_min;
+        float m_cellSize;
+        int m_cols;
+        int m_rows;
+        std::vector<unsigned int> m_cellStart;
+        // Edges of each cell, contiguous and split by coordinate
+        std::vector<float> m_ox, m_oy, m_dx, m_dy;
+        std::vector<unsigned int> m_index;
+        size_t m_edgeCount;
+
+        template <bool AnyHit>
+        bool traverse(const sf::Vector2f& origin,
+                      const sf::Vector2f& direction,
+                      float& t,
+                      unsigned int& entry) const;
+
+    public:
+        /**
+         * @brief Maximum number of cells in each axis.
+         * @details If the edges span a wider area, the cells are made bigger.
+         */
+        static const int MAX_CELLS = 1024;
+
+        /**
+         * @brief Construct an empty grid.
+         */
+        EdgeGrid();
+
+        /**
+         * @brief Construct a grid over a set of edges.
+         * @see build
+         */
+        explicit EdgeGrid(const std::vector<sfu::Line>& edges, float cellSize=64.f);
+
+        /**
+         * @brief Rebuild the grid over a set of edges.
+         * @details The edges are copied, so the vector may be changed or
+         * destroyed afterwards. The indices returned in RayHit::edge are the
+         * positions in @p edges.
+         * @param edges Segments that block the rays.
+         * @param cellSize Side of each cell. It should be close to the
+         * length of the edges.
+         */
+        void build(const std::vector<sfu::Line>& edges, float cellSize=64.f);
+
+        /**
+         * @brief Get the number of edges of the grid.
+         */
+        size_t getEdgeCount() const;
+
+        /**
+         * @brief Find the first edge hit by a ray.
+         * @param ray
+         * @returns The closest hit, with RayHit::hit false if there is none.
+         */
+        RayHit castRay(const sfu::Line& ray) const;
+
+        /**
+         * @brief Check if there is no edge between two points.
+         * @details It stops at the first edge found, so it is faster than
+         * castRay.
+         * @param p1
+         * @param p2
+         * @returns True if the segment from @p p1 to @p p2 hits no edge.
+         */
+        bool lineOfSight(const sf::Vector2f& p1, const sf::Vector2f& p2) const;
+
+        /**
+         * @brief Cast many rays in parallel.
+         * @param rays
+         * @param hits (Output argument) Result of each ray, in the same
+         * order.
+         * @param threads Number of threads. 0 means as many as the hardware
+         * supports.
+         * @see castRay
+         */
+        void castRays(const std::vector<sfu::Line>& rays,
+                      std::vector<RayHit>& hits,
+                      unsigned int threads=0) const;
+
+        /**
+         * @brief Check many lines of sight in parallel.
+         * @param segments Each one goes from its origin to point(1).
+         * @param visible (Output argument) 1 for each segment that hits no
+         * edge and 0 for the rest, in the same order.
+         * @param threads Number of threads. 0 means as many as the hardware
+         * supports.
+         * @see lineOfSight
+         */
+        void lineOfSight(const std::vector<sfu::Line>& segments,
+                         std::vector<char>& visible,
+                         unsigned int threads=0) const;
+    };
+}
+
+#endif
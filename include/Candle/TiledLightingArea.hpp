@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the TiledLightingArea class.
+ */
+#ifndef __CANDLE_TILED_LIGHTING_HPP__
+#define __CANDLE_TILED_LIGHTING_HPP__
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+#include "Candle/LightingArea.hpp"
+
+namespace candle{
+    /**
+     * @brief LightingArea split in tiles, for very big worlds.
+     * @details
+     *
+     * A TiledLightingArea covers a rectangle of the world with a grid of
+     * square tiles, each of them being a plain colored LightingArea. A tile
+     * only allocates its sf::RenderTexture while some registered light
+     * overlaps it; the rest of the area is drawn as plain color.
+     *
+     * Instead of clearing and redrawing everything each frame, the area
+     * keeps track of the tiles that need to be updated. Lights are
+     * registered with @ref addLight, and when one of them changes
+     * (moves, is casted again, ...) @ref invalidate must be called with it,
+     * which marks the tiles under its previous and current bounds as dirty.
+     * Then, @ref update clears and redraws only the dirty tiles.
+     *
+     * When drawn, only the tiles visible in the view of the target are
+     * composited.
+     *
+     * Unlike LightingArea, a TiledLightingArea is aligned with the world
+     * axes and can't be transformed nor textured.
+     */
+    class TiledLightingArea: public sf::Drawable{
+    private:
+        struct LightEntry{
+            const LightSource* light;
+            sf::FloatRect bounds;
+        };
+        LightingArea::Mode m_mode;
+        LightingArea::Backend m_backend;
+        sf::FloatRect m_bounds;
+        unsigned int m_tileSize;
+        int m_columns;
+        int m_rows;
+        sf::Color m_color;
+        float m_opacity;
+        std::map<int, std::unique_ptr<LightingArea>> m_tiles;
+        std::set<int> m_dirtyTiles;
+        std::vector<LightEntry> m_lights;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        sf::FloatRect getTileBounds(int tile) const;
+        void markDirty(const sf::FloatRect& region);
+        void markAllDirty();
+        sf::Color getActualColor() const;
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param mode
+         * @param position Top left corner of the area.
+         * @param size
+         * @param tileSize Side of the tiles, in pixels.
+         * @param backend Backend of the tiles.
+         */
+        TiledLightingArea(LightingArea::Mode mode,
+                          const sf::Vector2f& position,
+                          const sf::Vector2f& size,
+                          unsigned int tileSize=512,
+                          LightingArea::Backend backend=LightingArea::HARDWARE);
+
+        /**
+         * @brief Get the global bounding rectangle of the area.
+         * @returns Global bounding rectangle of the area.
+         */
+        sf::FloatRect getGlobalBounds() const;
+
+        /**
+         * @brief Get the side of the tiles.
+         * @returns The side of the tiles, in pixels.
+         */
+        unsigned int getTileSize() const;
+
+        /**
+         * @brief Get the number of tiles with an allocated render texture.
+         * @returns The number of allocated tiles.
+         */
+        size_t getAllocatedTileCount() const;
+
+        /**
+         * @brief Get the number of tiles pending to be updated.
+         * @returns The number of dirty tiles.
+         */
+        size_t getDirtyTileCount() const;
+
+        /**
+         * @brief Set color of the fog/light.
+         * @details All the allocated tiles are marked as dirty.
+         * @param color
+         * @see LightingArea::setAreaColor
+         */
+        void setAreaColor(sf::Color color);
+
+        /**
+         * @brief Get color of the fog/light.
+         * @returns The plain color of the fog/light.
+         */
+        sf::Color getAreaColor() const;
+
+        /**
+         * @brief Set the opacity of the fog/light.
+         * @details All the allocated tiles are marked as dirty.
+         * @param opacity
+         * @see LightingArea::setAreaOpacity
+         */
+        void setAreaOpacity(float opacity);
+
+        /**
+         * @brief Get the opacity of the fog/light.
+         * @returns The opacity of the fog/light.
+         */
+        float getAreaOpacity() const;
+
+        /**
+         * @brief Get the lighting mode.
+         * @returns The lighting mode.
+         */
+        LightingArea::Mode getMode() const;
+
+        /**
+         * @brief Register a light to be drawn in the area.
+         * @details The light must exist and be managed externally while it
+         * is registered.
+         * @param light
+         * @see removeLight, invalidate
+         */
+        void addLight(const LightSource& light);
+
+        /**
+         * @brief Unregister a light.
+         * @param light
+         * @see addLight
+         */
+        void removeLight(const LightSource& light);
+
+        /**
+         * @brief Notify that a registered light has changed.
+         * @details The tiles under the bounds of the light when it was last
+         * drawn and under its current bounds are marked as dirty.
+         * @param light
+         */
+        void invalidate(const LightSource& light);
+
+        /**
+         * @brief Mark the tiles intersecting a region as dirty.
+         * @param region Rectangle in global coordinates.
+         */
+        void invalidate(const sf::FloatRect& region);
+
+        /**
+         * @brief Clear and redraw the dirty tiles.
+         * @details Dirty tiles that are no longer overlapped by any light
+         * release their render texture.
+         */
+        void update();
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the functions to compute visibility polygons
+ * without graphics.
+ */
+#ifndef __CANDLE_VISIBILITY_HPP__
+#define __CANDLE_VISIBILITY_HPP__
+
+#include <vector>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "Candle/geometry/Line.hpp"
+
+namespace candle{
+    /**
+     * @brief Point from which the visibility is computed.
+     */
+    struct Viewpoint{
+        sf::Vector2f position; ///< Position of the viewer.
+        float range; ///< Half of the side of the square visible area.
+    };
+
+    /**
+     * @brief Compute the polygon visible from a point.
+     * @details It works on plain vectors, so it can be used without a
+     * graphics context (for example, in a server). It is part of the
+     * Candle-core library, that doesn't depend on sfml-graphics.
+     *
+     * It is not the algorithm of the lights: the visible area is limited by
+     * a square of half side @p viewpoint.range instead of a circle, and the
+     * rays are casted only towards the ends of the edges, with the
+     * predicates of sfu::castVisibility instead of extra rays with angular
+     * offsets. The float coordinates are converted to double to evaluate
+     * the predicates, so they are much more robust than in float, but not
+     * exact as with integer coordinates.
+     *
+     * The vertices are sorted by angle around the viewpoint, so they form a
+     * fan.
+     * @param edges Segments that block the view.
+     * @param viewpoint
+     * @param polygon (Output argument) Vertices of the visible polygon.
+     * @see sfu::castVisibility
+     */
+    void computeVisibility(const std::vector<sfu::Line>& edges,
+                           const Viewpoint& viewpoint,
+                           std::vector<sf::Vector2f>& polygon);
+
+    /**
+     * @brief Compute the polygons visible from many points in parallel.
+     * @details The viewpoints are split among @p threads threads. The
+     * result is the same as computing each one separately.
+     * @param edges Segments that block the view.
+     * @param viewpoints
+     * @param polygons (Output argument) Visible polygon of each viewpoint,
+     * in the same order.
+     * @param threads Number of threads. 0 means as many as the hardware
+     * supports.
+     */
+    void computeVisibility(const std::vector<sfu::Line>& edges,
+                           const std::vector<Viewpoint>& viewpoints,
+                           std::vector<std::vector<sf::Vector2f>>& polygons,
+                           unsigned int threads=0);
+}
+
+#endif
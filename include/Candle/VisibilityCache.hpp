@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the VisibilityCache class.
+ */
+#ifndef __CANDLE_VISIBILITY_CACHE_HPP__
+#define __CANDLE_VISIBILITY_CACHE_HPP__
+
+#include <list>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+
+namespace candle{
+    /**
+     * @brief Cache of the polygons casted by lights, to reuse them when a
+     * light returns to a previous state.
+     * @details
+     *
+     * Lights that follow a path (patrols, lanterns carried by NPCs) go
+     * through the same positions again and again. A VisibilityCache keeps
+     * the polygons of the last casts, indexed by the state of the light:
+     * the version of the edges, its position and rotation (quantized), its
+     * scale, its range and its beam. When a light is casted through the
+     * cache in a state that is already stored, the polygon is copied
+     * instead of being casted.
+     *
+     * The position is quantized to a grid of @p positionStep units and the
+     * rotation to steps of @p angleStep degrees, so a light may reuse the
+     * polygon of a slightly different state. Use small steps if the shadows
+     * must be exact.
+     *
+     * The version of the edges is given by the user with
+     * @ref setEdgeVersion, and must change every time the edges change.
+     * Going back to a previous version (for example, opening and closing a
+     * door) reuses its entries if they haven't been evicted.
+     *
+     * When the memory used by the polygons exceeds the limit, the least
+     * recently used ones are evicted.
+     */
+    class VisibilityCache{
+    public:
+        /**
+         * @brief Counters of the use of the cache.
+         * @see getStatistics
+         */
+        struct Statistics{
+            unsigned long hits; ///< Casts answered by the cache.
+            unsigned long misses; ///< Casts that were computed.
+            unsigned long evictions; ///< Entries removed to free memory.
+            size_t entries; ///< Number of polygons stored.
+            size_t memory; ///< Bytes used by the polygons stored.
+
+            /**
+             * @brief Get the fraction of casts answered by the cache.
+             * @returns hits / (hits + misses), or 0 if there were no casts.
+             */
+            float getHitRate() const;
+        };
+
+    private:
+        struct Key{
+            const std::type_info* type;
+            unsigned long version;
+            int x, y, rotation;
+            float scaleX, scaleY, range, beam;
+            bool operator == (const Key& other) const;
+        };
+        struct KeyHash{
+            size_t operator () (const Key& key) const;
+        };
+        struct Entry{
+            Key key;
+            sf::VertexArray polygon;
+        };
+        typedef std::list<Entry> EntryList;
+
+        EntryList m_entries;
+        std::unordered_map<Key, EntryList::iterator, KeyHash> m_index;
+        float m_positionStep;
+        float m_angleStep;
+        size_t m_maxMemory;
+        unsigned long m_version;
+        Statistics m_statistics;
+
+        Key makeKey(const LightSource& light) const;
+        static size_t getMemory(const sf::VertexArray& polygon);
+        void evict();
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param maxMemory Maximum number of bytes used by the polygons.
+         * @param positionStep Size of the grid to quantize the positions.
+         * @param angleStep Step, in degrees, to quantize the rotations.
+         */
+        explicit VisibilityCache(size_t maxMemory=4*1024*1024,
+                                 float positionStep=1.f,
+                                 float angleStep=0.5f);
+
+        /**
+         * @brief Set the version of the edges.
+         * @param version
+         * @see getEdgeVersion
+         */
+        void setEdgeVersion(unsigned long version);
+
+        /**
+         * @brief Get the version of the edges.
+         * @details It defaults to 0.
+         * @see setEdgeVersion
+         */
+        unsigned long getEdgeVersion() const;
+
+        /**
+         * @brief Set the maximum memory used by the polygons.
+         * @details If it is exceeded, the least recently used entries are
+         * evicted immediately.
+         * @param bytes
+         */
+        void setMaxMemory(size_t bytes);
+
+        /**
+         * @brief Get the maximum memory used by the polygons.
+         */
+        size_t getMaxMemory() const;
+
+        /**
+         * @brief Cast a light, reusing a stored polygon if possible.
+         * @details On a miss, the light is casted with
+         * LightSource::castLight and the polygon is stored.
+         * @param light
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         * @returns True if the polygon was found in the cache.
+         */
+        bool castLight(LightSource& light, const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+
+        /**
+         * @brief Remove all the entries.
+         * @details The statistics are kept.
+         */
+        void clear();
+
+        /**
+         * @brief Get the counters of the use of the cache.
+         */
+        Statistics getStatistics() const;
+
+        /**
+         * @brief Set the hits, misses and evictions to 0.
+         */
+        void resetStatistics();
+    };
+}
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the VisionMask class.
+ */
+#ifndef __CANDLE_VISION_MASK_HPP__
+#define __CANDLE_VISION_MASK_HPP__
+
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+#include "Candle/LightSource.hpp"
+#include "Candle/Visibility.hpp"
+#include "Candle/graphics/SoftwareTarget.hpp"
+
+namespace candle{
+    /**
+     * @brief Area seen by a group of viewpoints, merged in a single mask.
+     * @details
+     *
+     * To reveal in a FOG LightingArea what any unit of a squad sees, each
+     * unit could be a RadialLight, but then each light is casted and drawn
+     * on its own and the area overlapped by several units is drawn several
+     * times. A VisionMask computes the visibility of all the viewpoints at
+     * once (see computeVisibility) and merges it into a coverage mask of
+     * the bounding rectangle of the group, that is drawn to the area as a
+     * single textured quad.
+     *
+     * The edges are culled once against the bounds of the whole group, and
+     * the viewpoints are computed in parallel. The visible area of each
+     * viewpoint is a circle of its range. The mask is computed on the CPU
+     * with a texel size that can be greater than a pixel, as fog borders
+     * don't need to be sharp.
+     *
+     * Like LightSources, it is drawn with sf::BlendAdd instead of
+     * sf::BlendAlpha, and it can be drawn to a LightingArea in FOG mode.
+     */
+    class VisionMask: public sf::Drawable{
+    private:
+        friend class LightingArea;
+
+        std::vector<Viewpoint> m_viewpoints;
+        std::vector<std::vector<sf::Vector2f>> m_polygons;
+        float m_texelSize;
+        unsigned int m_threads;
+        sf::FloatRect m_bounds;
+        sfu::SoftwareTarget m_mask;
+        sf::Image m_image;
+        mutable sf::Texture m_texture;
+        mutable bool m_textureOutdated;
+        sf::VertexArray m_quad;
+
+        void draw(sf::RenderTarget& t, sf::RenderStates st) const override;
+        void rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const;
+
+    public:
+        /**
+         * @brief Constructor.
+         * @param texelSize Side of each texel of the mask, in world units.
+         */
+        explicit VisionMask(float texelSize=4.f);
+
+        /**
+         * @brief Add a viewpoint.
+         * @param position Position of the viewer.
+         * @param range Radius of the area it can see.
+         * @returns The index of the viewpoint.
+         */
+        size_t addViewpoint(const sf::Vector2f& position, float range);
+
+        /**
+         * @brief Move a viewpoint.
+         * @param i Index of the viewpoint.
+         * @param position Position of the viewer.
+         * @param range Radius of the area it can see.
+         */
+        void setViewpoint(size_t i, const sf::Vector2f& position, float range);
+
+        /**
+         * @brief Remove all the viewpoints.
+         */
+        void clearViewpoints();
+
+        /**
+         * @brief Get the number of viewpoints.
+         */
+        size_t getViewpointCount() const;
+
+        /**
+         * @brief Set the side of each texel of the mask.
+         * @details It is used the next time the mask is computed.
+         * @param size Side of each texel, in world units.
+         * @see getTexelSize
+         */
+        void setTexelSize(float size);
+
+        /**
+         * @brief Get the side of each texel of the mask.
+         * @see setTexelSize
+         */
+        float getTexelSize() const;
+
+        /**
+         * @brief Set the number of threads used to compute the visibility.
+         * @param threads Number of threads. 0 means as many as the hardware
+         * supports.
+         */
+        void setThreadCount(unsigned int threads);
+
+        /**
+         * @brief Compute the mask of the area seen by the viewpoints.
+         * @param begin Iterator to the first sfu::Line of the vector to take
+         * into account.
+         * @param end Iterator to the first sfu::Line of the vector not to be
+         * taken into account.
+         */
+        void compute(const EdgeVector::iterator& begin, const EdgeVector::iterator& end);
+
+        /**
+         * @brief Get the visible polygon of a viewpoint in the last
+         * computation.
+         * @details It is limited by the square of side 2 * range around
+         * the viewpoint; the mask cuts it to the circle.
+         * @param i Index of the viewpoint.
+         */
+        const std::vector<sf::Vector2f>& getPolygon(size_t i) const;
+
+        /**
+         * @brief Check if a point was seen in the last computation.
+         * @param point Point in global coordinates.
+         * @returns True if the texel of the mask that contains @p point is
+         * covered.
+         */
+        bool isVisible(const sf::Vector2f& point) const;
+
+        /**
+         * @brief Get the rectangle covered by the mask.
+         * @returns The bounds of the viewpoints in the last computation.
+         */
+        sf::FloatRect getGlobalBounds() const;
+    };
+}
+
+#endif
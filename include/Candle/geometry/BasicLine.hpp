@@ -0,0 +1,294 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the BasicLine struct and the raycast algorithms
+ * with exact predicates.
+ */
+#ifndef __SFML_UTIL_GEOMETRY_BASIC_LINE_HPP__
+#define __SFML_UTIL_GEOMETRY_BASIC_LINE_HPP__
+
+#include <algorithm>
+#include <vector>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace sfu{
+    /**
+     * @brief Types used to evaluate the predicates for a coordinate type.
+     * @details Wide is the type of the products of two coordinates. For
+     * int, it is long long, so the predicates are exact as long as the
+     * differences between coordinates are below 32768.
+     */
+    template <typename T>
+    struct GeometryTraits{
+        typedef T Wide; ///< Type of the products of two coordinates.
+    };
+
+    /**
+     * @brief GeometryTraits for integer coordinates.
+     */
+    template <>
+    struct GeometryTraits<int>{
+        typedef long long Wide; ///< Type of the products of two coordinates.
+    };
+
+    /**
+     * @brief 2D segment defined by an origin point and a direction vector,
+     * with coordinates of type T.
+     * @details Unlike @ref Line, it doesn't use angles nor tolerances, so
+     * with integer coordinates (for example, occluders aligned to a tile
+     * grid, or fixed-point positions) all the predicates are exact and the
+     * results are the same in every machine.
+     */
+    template <typename T>
+    struct BasicLine{
+        sf::Vector2<T> m_origin; ///< Origin point of the segment.
+        sf::Vector2<T> m_direction; ///< Vector from the origin to the other end.
+
+        /**
+         * @brief Construct a segment from @p p1 to @p p2
+         * @param p1 First point
+         * @param p2 Second point
+         */
+        BasicLine(const sf::Vector2<T>& p1, const sf::Vector2<T>& p2)
+            : m_origin(p1)
+            , m_direction(p2 - p1)
+            {}
+
+        /**
+         * @brief Get the end of the segment.
+         * @returns m_origin + m_direction
+         */
+        sf::Vector2<T> end() const{
+            return m_origin + m_direction;
+        }
+    };
+
+    /**
+     * @brief Get the cross product of two 2D vectors.
+     */
+    template <typename T>
+    typename GeometryTraits<T>::Wide cross(const sf::Vector2<T>& v1, const sf::Vector2<T>& v2){
+        typedef typename GeometryTraits<T>::Wide W;
+        return (W)v1.x*v2.y - (W)v1.y*v2.x;
+    }
+
+    /**
+     * @brief Get the side of a point relative to a direction.
+     * @returns 1 if @p p is counter-clockwise from @p d (that is, at a
+     * greater angle), -1 if it is clockwise and 0 if they are aligned.
+     */
+    template <typename T>
+    int orientation(const sf::Vector2<T>& d, const sf::Vector2<T>& p){
+        typename GeometryTraits<T>::Wide c = cross(d, p);
+        return (0 < c) - (c < 0);
+    }
+
+    /**
+     * @brief Distance along a ray, as a fraction num/den with den > 0.
+     */
+    template <typename T>
+    struct RayParam{
+        typename GeometryTraits<T>::Wide num; ///< Numerator.
+        typename GeometryTraits<T>::Wide den; ///< Positive denominator.
+
+        /**
+         * @brief Compare two parameters exactly.
+         */
+        bool operator < (const RayParam& other) const{
+            return num*other.den < other.num*den;
+        }
+    };
+
+    /**
+     * @brief Intersect a ray with a segment.
+     * @details The ray starts at @p origin and its parameter is 1 at
+     * origin + @p dir. Segments aligned with the ray don't block it.
+     * @param origin Origin of the ray.
+     * @param dir Direction of the ray.
+     * @param seg Segment.
+     * @param t (Output argument) Parameter of the intersection.
+     * @param sides (Output argument) Sides of the ray that are blocked from
+     * @p t on: 1 for the counter-clockwise side, 2 for the clockwise side
+     * and 3 for both (the segment crosses the ray).
+     * @returns True if the segment is hit in front of @p origin.
+     */
+    template <typename T>
+    bool intersectRay(const sf::Vector2<T>& origin,
+                      const sf::Vector2<T>& dir,
+                      const BasicLine<T>& seg,
+                      RayParam<T>& t,
+                      int& sides){
+        const sf::Vector2<T> a = seg.m_origin - origin;
+        const sf::Vector2<T> b = seg.end() - origin;
+        int oa = orientation(dir, a);
+        int ob = orientation(dir, b);
+        if(oa == ob){
+            // Both ends at the same side, or aligned with the ray
+            return false;
+        }
+        if(oa != 0 && ob != 0){
+            t.num = cross(a, seg.m_direction);
+            t.den = cross(dir, seg.m_direction);
+            if(t.den < 0){
+                t.num = -t.num;
+                t.den = -t.den;
+            }
+            sides = 3;
+        }else{
+            // Only one end touches the ray
+            const sf::Vector2<T>& p = oa == 0 ? a : b;
+            typedef typename GeometryTraits<T>::Wide W;
+            t.num = (W)p.x*dir.x + (W)p.y*dir.y;
+            t.den = (W)dir.x*dir.x + (W)dir.y*dir.y;
+            sides = (oa > 0 || ob > 0) ? 1 : 2;
+        }
+        return t.num > 0;
+    }
+
+    /**
+     * @brief Get the point of a ray at a given parameter.
+     */
+    template <typename T>
+    sf::Vector2f rayPoint(const sf::Vector2<T>& origin, const sf::Vector2<T>& dir, const RayParam<T>& t){
+        double f = (double)t.num / (double)t.den;
+        return sf::Vector2f(origin.x + dir.x*f, origin.y + dir.y*f);
+    }
+
+    /**
+     * @brief Cast a ray against a set of segments with exact predicates.
+     * @details The @p ray is interpreted as a segment: it is casted from its
+     * origin and it reaches, at most, ray.end(). Segments that only touch
+     * the ray with one end stop it too.
+     * @param begin Iterator to the first segment.
+     * @param end Iterator to the first segment not to be taken into account.
+     * @param ray
+     * @returns The closest point hit, or ray.end() if nothing is hit.
+     * @see castRay(const Iterator&, const Iterator&, Line, float)
+     */
+    template <typename T, typename Iterator>
+    sf::Vector2f castRay(const Iterator& begin,
+                         const Iterator& end,
+                         const BasicLine<T>& ray){
+        RayParam<T> nearest;
+        nearest.num = nearest.den = 1;
+        for(auto it = begin; it != end; it++){
+            RayParam<T> t;
+            int sides;
+            if(intersectRay(ray.m_origin, ray.m_direction, *it, t, sides) && t < nearest){
+                nearest = t;
+            }
+        }
+        return rayPoint(ray.m_origin, ray.m_direction, nearest);
+    }
+
+    /**
+     * @brief Compute the polygon visible from a point.
+     * @details The rays are casted only towards the ends of the segments,
+     * inside the square of side 2 * @p range centered in @p origin, and
+     * towards its corners. When a ray passes by an end, the hits at each side
+     * of the ray are computed exactly, so no extra rays with angular
+     * offsets are needed and no slivers are missed.
+     *
+     * The segments must not cross each other, except at their ends, as the
+     * edges of a grid of tiles.
+     *
+     * The polygon is returned as its vertices sorted by angle (as
+     * @ref angle), to be drawn as a fan around @p origin.
+     * @param begin Iterator to the first segment.
+     * @param end Iterator to the first segment not to be taken into account.
+     * @param origin Point of view.
+     * @param range Half of the side of the square that limits the view.
+     * @param polygon (Output argument) Vertices of the visible polygon.
+     */
+    template <typename T, typename Iterator>
+    void castVisibility(const Iterator& begin,
+                        const Iterator& end,
+                        const sf::Vector2<T>& origin,
+                        T range,
+                        std::vector<sf::Vector2f>& polygon){
+        typedef sf::Vector2<T> V;
+        polygon.clear();
+        const V lo(origin.x - range, origin.y - range);
+        const V hi(origin.x + range, origin.y + range);
+        auto inside = [&](const V& p){
+            return p.x >= lo.x && p.x <= hi.x && p.y >= lo.y && p.y <= hi.y;
+        };
+
+        // Segments that may be hit, plus the limits of the view
+        std::vector<BasicLine<T>> segments = {
+            BasicLine<T>(lo, V(hi.x, lo.y)),
+            BasicLine<T>(V(hi.x, lo.y), hi),
+            BasicLine<T>(hi, V(lo.x, hi.y)),
+            BasicLine<T>(V(lo.x, hi.y), lo)
+        };
+        std::vector<V> targets = {
+            lo - origin,
+            V(hi.x, lo.y) - origin,
+            hi - origin,
+            V(lo.x, hi.y) - origin
+        };
+        for(auto it = begin; it != end; it++){
+            const BasicLine<T>& s = *it;
+            V p1 = s.m_origin, p2 = s.end();
+            if(std::max(p1.x, p2.x) < lo.x || std::min(p1.x, p2.x) > hi.x ||
+               std::max(p1.y, p2.y) < lo.y || std::min(p1.y, p2.y) > hi.y){
+                continue;
+            }
+            segments.push_back(s);
+            if(inside(p1) && p1 != origin){
+                targets.push_back(p1 - origin);
+            }
+            if(inside(p2) && p2 != origin){
+                targets.push_back(p2 - origin);
+            }
+        }
+
+        // Sort by angle in [0, 360), as sfu::angle
+        auto half = [](const V& v){
+            return v.y < 0 || (v.y == 0 && v.x < 0);
+        };
+        std::sort(targets.begin(), targets.end(), [&](const V& a, const V& b){
+            bool ha = half(a), hb = half(b);
+            if(ha != hb){
+                return hb;
+            }
+            return cross(a, b) > 0;
+        });
+
+        for(size_t i = 0; i < targets.size(); i++){
+            const V& dir = targets[i];
+            if(i > 0 && cross(targets[i-1], dir) == 0 && half(targets[i-1]) == half(dir)){
+                // Same ray as the previous target
+                continue;
+            }
+            RayParam<T> cw, ccw;
+            cw.num = ccw.num = 0;
+            cw.den = ccw.den = 1;
+            bool hitCw = false, hitCcw = false;
+            for(auto& s: segments){
+                RayParam<T> t;
+                int sides;
+                if(!intersectRay(origin, dir, s, t, sides)){
+                    continue;
+                }
+                if((sides & 2) && (!hitCw || t < cw)){
+                    cw = t;
+                    hitCw = true;
+                }
+                if((sides & 1) && (!hitCcw || t < ccw)){
+                    ccw = t;
+                    hitCcw = true;
+                }
+            }
+            // The limits of the view always block both sides
+            polygon.push_back(rayPoint(origin, dir, cw));
+            if(cw < ccw || ccw < cw){
+                polygon.push_back(rayPoint(origin, dir, ccw));
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the Capsule struct and the raycast against
+ * round occluders.
+ */
+#ifndef __SFML_UTIL_GEOMETRY_CAPSULE_HPP__
+#define __SFML_UTIL_GEOMETRY_CAPSULE_HPP__
+
+#include <algorithm>
+#include <limits>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include "Candle/geometry/Line.hpp"
+
+namespace sfu{
+    /**
+     * @brief Round occluder: the points within a distance of a segment.
+     * @details A circle is a capsule whose both ends are the same point.
+     * Capsules are tested analytically against the rays, instead of being
+     * tessellated into lines.
+     */
+    struct Capsule{
+        sf::Vector2f m_p1; ///< First end of the axis.
+        sf::Vector2f m_p2; ///< Second end of the axis.
+        float m_radius; ///< Radius around the axis.
+
+        /**
+         * @brief Construct a circle.
+         * @param center
+         * @param radius
+         */
+        Capsule(const sf::Vector2f& center, float radius);
+
+        /**
+         * @brief Construct a capsule around the segment from @p p1 to @p p2.
+         * @param p1
+         * @param p2
+         * @param radius
+         */
+        Capsule(const sf::Vector2f& p1, const sf::Vector2f& p2, float radius);
+
+        /**
+         * @brief Get the global bounding rectangle of the capsule.
+         * @returns Global bounding rectangle in float
+         */
+        sf::FloatRect getGlobalBounds() const;
+
+        /**
+         * @brief Check if a point is inside the capsule.
+         * @param point
+         * @returns True if the point is inside or on the border.
+         */
+        bool contains(const sf::Vector2f& point) const;
+
+        /**
+         * @brief Get the closest intersection of a ray with the border.
+         * @details Rays casted from inside the capsule don't intersect it,
+         * so a light inside a round occluder is not blocked by it.
+         * @param ray Ray casted from its origin in its direction.
+         * @param t (Output argument) Magnitude required to get the
+         * intersection point from the direction of @p ray.
+         * @returns True, if there is an intersection.
+         */
+        bool intersection(const Line& ray, float& t) const;
+
+        /**
+         * @brief Get the points of the silhouette seen from a point.
+         * @details These are the tangent points of the two lines from
+         * @p point that touch the capsule without crossing it, so the
+         * capsule occludes exactly the angle between them.
+         * @param point
+         * @param t1 (Output argument)
+         * @param t2 (Output argument)
+         * @returns False if @p point is inside the capsule.
+         */
+        bool tangents(const sf::Vector2f& point, sf::Vector2f& t1, sf::Vector2f& t2) const;
+
+        /**
+         * @brief Get the points of the silhouette seen along a direction.
+         * @details Like @ref tangents, for parallel rays with direction
+         * @p direction.
+         * @param direction
+         * @param t1 (Output argument)
+         * @param t2 (Output argument)
+         */
+        void parallelTangents(const sf::Vector2f& direction, sf::Vector2f& t1, sf::Vector2f& t2) const;
+    };
+
+    /**
+     * @brief Cast a ray against a set of segments and a set of capsules.
+     * @details Same as castRay(const Iterator&, const Iterator&, Line, float)
+     * but the ray can also be stopped by the capsules.
+     * @param begin Iterator to the first segment.
+     * @param end Iterator to the last segment.
+     * @param capsulesBegin Iterator to the first capsule.
+     * @param capsulesEnd Iterator to the last capsule.
+     * @param ray
+     * @param maxRange Optional argument to indicate the max distance allowed
+     * for a ray to hit a segment or a capsule.
+     */
+    template <typename Iterator, typename CapsuleIterator>
+    sf::Vector2f castRay(const Iterator& begin,
+                         const Iterator& end,
+                         const CapsuleIterator& capsulesBegin,
+                         const CapsuleIterator& capsulesEnd,
+                         Line ray,
+                         float maxRange=std::numeric_limits<float>::infinity()){
+        ray.m_direction = sfu::normalize(ray.m_direction);
+        sf::Vector2f hit = castRay(begin, end, ray, maxRange);
+        float minRange = std::min(maxRange, sfu::magnitude(hit - ray.m_origin));
+        for(auto it = capsulesBegin; it != capsulesEnd; it++){
+            float t;
+            if(it -> intersection(ray, t) && t <= minRange){
+                minRange = t;
+                hit = ray.point(t);
+            }
+        }
+        return hit;
+    }
+}
+
+#endif
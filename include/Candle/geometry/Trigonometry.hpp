@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the trigonometric functions used to build rays.
+ */
+#ifndef __SFML_UTIL_GEOMETRY_TRIGONOMETRY_HPP__
+#define __SFML_UTIL_GEOMETRY_TRIGONOMETRY_HPP__
+
+#include <SFML/System/Vector2.hpp>
+
+namespace sfu{
+    /**
+     * @brief Compute the sine and the cosine of an angle in degrees.
+     * @details By default, it uses std::sin and std::cos after reducing the
+     * angle to [-180, 180).
+     *
+     * If CANDLE_FAST_TRIG is defined, the angle is reduced to
+     * [-45, 45] degrees around the closest multiple of 90 and both values are
+     * approximated with polynomials. It is about three times faster, and the
+     * absolute error is below 1e-7 for angles up to ±10⁶ degrees.
+     * @param degrees Angle in degrees.
+     * @param sin (Output argument) Sine of the angle.
+     * @param cos (Output argument) Cosine of the angle.
+     */
+    void sincos(float degrees, float& sin, float& cos);
+
+    /**
+     * @brief Rotate a 2D vector.
+     * @details The angle is given by its precomputed cosine and sine, to
+     * rotate many vectors by the same angle.
+     * @param v
+     * @param cos Cosine of the angle.
+     * @param sin Sine of the angle.
+     * @returns The rotated vector.
+     */
+    template <typename T>
+    sf::Vector2<T> rotate(const sf::Vector2<T>& v, T cos, T sin){
+        return sf::Vector2<T>(v.x*cos - v.y*sin, v.x*sin + v.y*cos);
+    }
+}
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @author Miguel Mejía Jiménez
+ * @copyright MIT License
+ * @brief This file contains the SoftwareTarget class.
+ */
+#ifndef __SFML_UTIL_GRAPHICS_SOFTWARETARGET_HPP__
+#define __SFML_UTIL_GRAPHICS_SOFTWARETARGET_HPP__
+
+#include <vector>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+namespace sfu{
+    /**
+     * @brief CPU render target that rasterizes vertex arrays into a float
+     * RGBA buffer.
+     * @details It mimics the part of sf::RenderTarget used by Candle, so it
+     * can produce light maps without an OpenGL context. Each pixel is stored
+     * as four floats in the range [0, 1], in RGBA order.
+     *
+     * The blend mode of the sf::RenderStates passed to @ref draw is honored,
+     * as well as the transform. The texture pointer is ignored, as a
+     * sf::Texture can't be read without a context; a @ref TextureFunction or a
+     * sf::Image can be used instead.
+     */
+    class SoftwareTarget{
+    public:
+        /**
+         * @brief Procedural texture.
+         * @details Receives the texture coordinates of a pixel and returns
+         * the value that multiplies the four channels of its color.
+         */
+        typedef float (*TextureFunction)(const sf::Vector2f& texCoords);
+
+        /**
+         * @brief Constructor.
+         * @details The target is empty until @ref create is called.
+         */
+        SoftwareTarget();
+
+        /**
+         * @brief Allocate the buffer.
+         * @param width
+         * @param height
+         */
+        void create(unsigned int width, unsigned int height);
+
+        /**
+         * @brief Get the size of the buffer, in pixels.
+         */
+        sf::Vector2u getSize() const;
+
+        /**
+         * @brief Fill the entire buffer with a single color.
+         * @param color
+         */
+        void clear(const sf::Color& color=sf::Color(0, 0, 0, 255));
+
+        /**
+         * @brief Rasterize a vertex array with a procedural texture.
+         * @details Supported primitive types are sf::Triangles,
+         * sf::TriangleStrip, sf::TriangleFan and sf::Quads. The rest are
+         * ignored.
+         * @param vertices
+         * @param states Transform and blend mode to use.
+         * @param texture Optional procedural texture.
+         */
+        void draw(const sf::VertexArray& vertices,
+                  const sf::RenderStates& states=sf::RenderStates::Default,
+                  TextureFunction texture=nullptr);
+
+        /**
+         * @brief Rasterize a vertex array with an image as texture.
+         * @details Texture coordinates are in pixels, as with sf::Texture,
+         * and are sampled with the nearest neighbour.
+         * @param vertices
+         * @param states Transform and blend mode to use.
+         * @param texture
+         */
+        void draw(const sf::VertexArray& vertices,
+                  const sf::RenderStates& states,
+                  const sf::Image& texture);
+
+        /**
+         * @brief Get the color of a pixel.
+         * @param x
+         * @param y
+         * @returns The color of the pixel, quantized to 8 bits per channel.
+         */
+        sf::Color getPixel(unsigned int x, unsigned int y) const;
+
+        /**
+         * @brief Get a read-only pointer to the buffer.
+         * @details The buffer has width * height * 4 floats, row by row.
+         * @returns Pointer to the first channel of the first pixel.
+         */
+        const float* getPixelsPtr() const;
+
+        /**
+         * @brief Copy the buffer to an image, quantized to 8 bits.
+         * @returns The image with the content of the buffer.
+         */
+        sf::Image copyToImage() const;
+
+    private:
+        std::vector<float> m_pixels;
+        unsigned int m_width;
+        unsigned int m_height;
+
+        template <typename Sampler>
+        void drawPrimitives(const sf::VertexArray& vertices,
+                            const sf::RenderStates& states,
+                            const Sampler& sampler);
+        template <typename Sampler, typename Blender>
+        void drawPrimitives(const sf::VertexArray& vertices,
+                            const sf::Transform& transform,
+                            const Sampler& sampler,
+                            const Blender& blender);
+        template <typename Sampler, typename Blender>
+        void drawTriangle(const sf::Vertex& v0,
+                          const sf::Vertex& v1,
+                          const sf::Vertex& v2,
+                          const Sampler& sampler,
+                          const Blender& blender);
+    };
+}
+
+#endif
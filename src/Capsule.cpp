@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Candle/geometry/Capsule.hpp"
+#include "Candle/geometry/Vector2.hpp"
+
+namespace sfu{
+    namespace{
+        float cross(const sf::Vector2f& a, const sf::Vector2f& b){
+            return a.x*b.y - a.y*b.x;
+        }
+
+        // Closest hit of a ray from outside the circle
+        bool intersectCircle(const Line& ray, const sf::Vector2f& center, float radius, float& t){
+            sf::Vector2f f = ray.m_origin - center;
+            float a = sfu::dot(ray.m_direction, ray.m_direction);
+            float b = sfu::dot(f, ray.m_direction);
+            float c = sfu::dot(f, f) - radius*radius;
+            float disc = b*b - a*c;
+            if(disc < 0.f){
+                return false;
+            }
+            t = (-b - std::sqrt(disc)) / a;
+            return t >= 0.f;
+        }
+
+        bool intersectSegment(const Line& ray, const sf::Vector2f& p1, const sf::Vector2f& p2, float& t){
+            sf::Vector2f e = p2 - p1;
+            float denom = cross(ray.m_direction, e);
+            if(denom == 0.f){
+                return false;
+            }
+            sf::Vector2f op = p1 - ray.m_origin;
+            t = cross(op, e) / denom;
+            float u = cross(op, ray.m_direction) / denom;
+            return t >= 0.f && u >= 0.f && u <= 1.f;
+        }
+
+        bool circleTangents(const sf::Vector2f& point, const sf::Vector2f& center, float radius, sf::Vector2f& t1, sf::Vector2f& t2){
+            sf::Vector2f u = point - center;
+            float l2 = sfu::magnitude2(u);
+            if(l2 <= radius*radius){
+                return false;
+            }
+            sf::Vector2f along = u * (radius*radius / l2);
+            sf::Vector2f across = sf::Vector2f(-u.y, u.x) * (radius * std::sqrt(l2 - radius*radius) / l2);
+            t1 = center + along - across;
+            t2 = center + along + across;
+            return true;
+        }
+    }
+
+    Capsule::Capsule(const sf::Vector2f& center, float radius):
+        m_p1(center),
+        m_p2(center),
+        m_radius(radius){}
+
+    Capsule::Capsule(const sf::Vector2f& p1, const sf::Vector2f& p2, float radius):
+        m_p1(p1),
+        m_p2(p2),
+        m_radius(radius){}
+
+    sf::FloatRect Capsule::getGlobalBounds() const{
+        float left = std::min(m_p1.x, m_p2.x) - m_radius;
+        float top = std::min(m_p1.y, m_p2.y) - m_radius;
+        return sf::FloatRect(left, top,
+                             std::abs(m_p2.x - m_p1.x) + m_radius*2,
+                             std::abs(m_p2.y - m_p1.y) + m_radius*2);
+    }
+
+    bool Capsule::contains(const sf::Vector2f& point) const{
+        sf::Vector2f axis = m_p2 - m_p1;
+        float l2 = sfu::magnitude2(axis);
+        float s = l2 == 0.f ? 0.f : std::max(0.f, std::min(1.f, sfu::dot(point - m_p1, axis) / l2));
+        return sfu::magnitude2(point - (m_p1 + s*axis)) <= m_radius*m_radius;
+    }
+
+    bool Capsule::intersection(const Line& ray, float& t) const{
+        if(contains(ray.m_origin)){
+            return false;
+        }
+        bool hit = false;
+        float tt;
+        t = std::numeric_limits<float>::infinity();
+        if(intersectCircle(ray, m_p1, m_radius, tt)){
+            t = tt;
+            hit = true;
+        }
+        if(m_p1 != m_p2){
+            if(intersectCircle(ray, m_p2, m_radius, tt) && tt < t){
+                t = tt;
+                hit = true;
+            }
+            sf::Vector2f n = sfu::normalize(m_p2 - m_p1) * m_radius;
+            n = {-n.y, n.x};
+            if(intersectSegment(ray, m_p1 + n, m_p2 + n, tt) && tt < t){
+                t = tt;
+                hit = true;
+            }
+            if(intersectSegment(ray, m_p1 - n, m_p2 - n, tt) && tt < t){
+                t = tt;
+                hit = true;
+            }
+        }
+        return hit;
+    }
+
+    bool Capsule::tangents(const sf::Vector2f& point, sf::Vector2f& t1, sf::Vector2f& t2) const{
+        if(contains(point)){
+            return false;
+        }
+        circleTangents(point, m_p1, m_radius, t1, t2);
+        if(m_p1 == m_p2){
+            return true;
+        }
+        // The silhouette is made of the outermost tangents to both ends
+        sf::Vector2f candidates[4];
+        candidates[0] = t1;
+        candidates[1] = t2;
+        circleTangents(point, m_p2, m_radius, candidates[2], candidates[3]);
+        sf::Vector2f ref = (m_p1 + m_p2) * 0.5f - point;
+        float amin = 0.f, amax = 0.f;
+        for(int i = 0; i < 4; i++){
+            sf::Vector2f v = candidates[i] - point;
+            float a = std::atan2(cross(ref, v), sfu::dot(ref, v));
+            if(i == 0 || a < amin){
+                amin = a;
+                t1 = candidates[i];
+            }
+            if(i == 0 || a > amax){
+                amax = a;
+                t2 = candidates[i];
+            }
+        }
+        return true;
+    }
+
+    void Capsule::parallelTangents(const sf::Vector2f& direction, sf::Vector2f& t1, sf::Vector2f& t2) const{
+        sf::Vector2f n = sfu::normalize(sf::Vector2f(-direction.y, direction.x)) * m_radius;
+        float s1 = sfu::dot(m_p1, n), s2 = sfu::dot(m_p2, n);
+        const sf::Vector2f& low = s1 < s2 ? m_p1 : m_p2;
+        const sf::Vector2f& high = s1 < s2 ? m_p2 : m_p1;
+        t1 = low - n;
+        t2 = high + n;
+    }
+}
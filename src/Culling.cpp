@@ -0,0 +1,27 @@
+#include "Candle/Culling.hpp"
+
+namespace candle{
+    sf::FloatRect getViewBounds(const sf::View& view){
+        return view.getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+    }
+
+    Visibility testVisibility(const LightSource& light, const sf::FloatRect& region){
+        sf::FloatRect bounds = light.getGlobalBounds();
+        sf::FloatRect inter;
+        if(!bounds.intersects(region, inter)){
+            return HIDDEN;
+        }
+        if(inter == bounds){
+            return VISIBLE;
+        }
+        return PARTIALLY_VISIBLE;
+    }
+
+    void cullLights(const LightTree& tree,
+                    const sf::FloatRect& region,
+                    std::vector<CulledLight>& visible){
+        std::vector<LightSource*> candidates;
+        tree.query(region, candidates);
+        cullLights(candidates.begin(), candidates.end(), region, visible);
+    }
+}
@@ -1,5 +1,6 @@
 #include "Candle/DirectedLight.hpp"
 
+#include <algorithm>
 #include <queue>
 
 #include "Candle/geometry/Vector2.hpp"
@@ -20,24 +21,44 @@ namespace candle{
 #endif
     }
 
-    void DirectedLight::resetColor(){
-        int quads = m_polygon.getVertexCount() / 4;
+    void DirectedLight::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        st.transform *= Transformable::getTransform();
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        t.draw(m_polygon, st);
+    }
+
+    // Color the quads of the polygon. Without fade all the vertices get the
+    // same color, so the distances aren't computed.
+    template <bool Fade>
+    void colorQuads(sf::VertexArray& polygon, const sf::Color& color, float range){
+        int quads = polygon.getVertexCount() / 4;
         for(int i = 0; i < quads; i++){
-            float p1 = i*4;
-            float p2 = p1+1;
-            float p3 = p1+2;
-            float p4 = p1+3;
-            sf::Vector2f r1 = m_polygon[p1].position;
-            sf::Vector2f r2 = m_polygon[p2].position;
-            sf::Vector2f r3 = m_polygon[p4].position;
-            sf::Vector2f r4 = m_polygon[p3].position;
-
-            float dr1 = 1.f - m_fade * (sfu::magnitude(r2-r1) / m_range);
-            float dr2 = 1.f - m_fade * (sfu::magnitude(r4-r3) / m_range);
-            m_polygon[p1].color = m_polygon[p2].color =
-                m_polygon[p3].color = m_polygon[p4].color = m_color;
-            m_polygon[p2].color.a = m_color.a * dr1;
-            m_polygon[p3].color.a = m_color.a * dr2;
+            int p1 = i*4;
+            int p2 = p1+1;
+            int p3 = p1+2;
+            int p4 = p1+3;
+            polygon[p1].color = polygon[p2].color =
+                polygon[p3].color = polygon[p4].color = color;
+            if(Fade){
+                sf::Vector2f r1 = polygon[p1].position;
+                sf::Vector2f r2 = polygon[p2].position;
+                sf::Vector2f r3 = polygon[p4].position;
+                sf::Vector2f r4 = polygon[p3].position;
+                float dr1 = 1.f - sfu::magnitude(r2-r1) / range;
+                float dr2 = 1.f - sfu::magnitude(r4-r3) / range;
+                polygon[p2].color.a = color.a * dr1;
+                polygon[p3].color.a = color.a * dr2;
+            }
+        }
+    }
+
+    void DirectedLight::resetColor(){
+        if(m_fade){
+            colorQuads<true>(m_polygon, m_color, m_range);
+        }else{
+            colorQuads<false>(m_polygon, m_color, m_range);
         }
     }
 
@@ -46,6 +67,11 @@ namespace candle{
         m_polygon.resize(2);
         setBeamWidth(10.f);
         // castLight();
+        allowAsyncCast(typeid(DirectedLight));
+    }
+
+    DirectedLight::~DirectedLight(){
+        waitForCast();
     }
 
     void DirectedLight::setBeamWidth(float width){
@@ -56,6 +82,49 @@ namespace candle{
         return m_beamWidth;
     }
 
+    sf::FloatRect DirectedLight::getLocalBounds() const{
+        return sf::FloatRect(0.f, -m_beamWidth/2.f, m_range, m_beamWidth);
+    }
+
+    sf::FloatRect DirectedLight::getGlobalBounds() const{
+        return Transformable::getTransform().transformRect(getLocalBounds());
+    }
+
+    float DirectedLight::getIllumination(const sf::Vector2f& point) const{
+        int quads = m_polygon.getVertexCount() / 4;
+        sf::Vector2f p = Transformable::getInverseTransform().transformPoint(point);
+        if(quads == 0 || p.x < 0.f || p.x > m_range){
+            return 0.f;
+        }
+        // Each quad goes from the ray at its vertices 0 and 1 to the ray at
+        // 3 and 2, and the rays are sorted across the beam
+        float dir = m_polygon[m_polygon.getVertexCount() - 1].position.y < m_polygon[0].position.y ? -1.f : 1.f;
+        float y = p.y * dir;
+        if(y < m_polygon[0].position.y * dir || y > m_polygon[quads*4 - 1].position.y * dir){
+            return 0.f;
+        }
+        int lo = 0, hi = quads - 1;
+        while(lo < hi){
+            int mid = (lo + hi) / 2;
+            if(m_polygon[mid*4 + 3].position.y * dir < y){
+                lo = mid + 1;
+            }else{
+                hi = mid;
+            }
+        }
+        // Length of the quad at the height of the point
+        const sf::Vector2f& r1 = m_polygon[lo*4 + 1].position;
+        const sf::Vector2f& r2 = m_polygon[lo*4 + 2].position;
+        float length = r1.y == r2.y ?
+            std::max(r1.x, r2.x) :
+            r1.x + (r2.x - r1.x) * (p.y - r1.y) / (r2.y - r1.y);
+        if(p.x > length){
+            return 0.f;
+        }
+        float falloff = m_fade ? 1.f - p.x / m_range : 1.f;
+        return falloff * getIntensity();
+    }
+
     struct LineParam: public sfu::Line{
         float param;
         LineParam(float f, const sfu::Line& l)
@@ -68,7 +137,14 @@ namespace candle{
     bool operator < (const LineParam& a, const LineParam& b){
         return a.param < b.param;
     }
-    void DirectedLight::castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+    void DirectedLight::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon){
+        CapsuleVector none;
+        castPolygon(begin, end, none.begin(), none.end(), polygon);
+    }
+
+    void DirectedLight::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                    const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                                    sf::VertexArray& polygon){
         sf::Transform trm = Transformable::getTransform();
         sf::Transform trm_i = trm.getInverse();
 
@@ -120,52 +196,65 @@ namespace candle{
                 rays.emplace(raySrc.point(t + off), lightDir, t + off);
             }
         }
+        for(auto it = capsulesBegin; it != capsulesEnd; it++){
+            sf::Vector2f tangent[2];
+            it->parallelTangents(lightDir, tangent[0], tangent[1]);
+            for(int i = 0; i < 2; i++){
+                // A ray at each side of the silhouette, one hitting the
+                // capsule and the other passing by
+                float t;
+                if(baseBeam.contains(trm_i.transformPoint(tangent[i]))){
+                    raySrc.intersection(sfu::Line(tangent[i], tangent[i]-lightDir), t);
+                    rays.emplace(raySrc.point(t - off), lightDir, t - off);
+                    rays.emplace(raySrc.point(t + off), lightDir, t + off);
+                }
+            }
+        }
         std::vector<sf::Vector2f> points;
         points.reserve(rays.size()*2);
 #ifdef CANDLE_DEBUG
+        sf::VertexArray& debug = getDebugLines(polygon);
         int deb_r = rays.size()*2 + 4;
-        m_debug.resize(deb_r);
-        sfu::setColor(m_debug, sf::Color::Magenta);
+        debug.resize(deb_r);
+        sfu::setColor(debug, sf::Color::Magenta);
         int i=0;
-        m_debug[deb_r-1].color = m_debug[deb_r-2].color = sf::Color::Cyan;
-        m_debug[deb_r-3].color = m_debug[deb_r-4].color = sf::Color::Yellow;
-        m_debug[deb_r-1].position = {0, -widthHalf};
-        m_debug[deb_r-2].position = {0, widthHalf};
-        m_debug[deb_r-3].position = {m_range, -widthHalf};
-        m_debug[deb_r-4].position = {m_range, widthHalf};
+        debug[deb_r-1].color = debug[deb_r-2].color = sf::Color::Cyan;
+        debug[deb_r-3].color = debug[deb_r-4].color = sf::Color::Yellow;
+        debug[deb_r-1].position = {0, -widthHalf};
+        debug[deb_r-2].position = {0, widthHalf};
+        debug[deb_r-3].position = {m_range, -widthHalf};
+        debug[deb_r-4].position = {m_range, widthHalf};
 #endif
         while(!rays.empty()){
             LineParam r = rays.top();
 
             sf::Vector2f p1 = trm_i.transformPoint(r.m_origin);
-            sf::Vector2f p2 = trm_i.transformPoint(sfu::castRay(begin, end, r, m_range));
+            sf::Vector2f p2 = trm_i.transformPoint(sfu::castRay(begin, end, capsulesBegin, capsulesEnd, r, m_range));
             points.push_back(p1);
             points.push_back(p2);
 #ifdef CANDLE_DEBUG
-            m_debug[i++].position = p1;
-            m_debug[i++].position = p2;
+            debug[i++].position = p1;
+            debug[i++].position = p2;
 #endif
             rays.pop();
         }
         if(!points.empty()){
             int quads = points.size()/2-1; // a quad between every two rays
-            m_polygon.resize(quads * 4);
+            polygon.resize(quads * 4);
             for(int i = 0; i < quads; i++){
                 float p1 = i*4,  r1 = i*2;
                 float p2 = p1+1, r2 = r1+1;
                 float p3 = p1+2, r3 = r1+2;
                 float p4 = p1+3, r4 = r1+3;
-                m_polygon[p1].position = points[r1];
-                m_polygon[p2].position = points[r2];
-                m_polygon[p3].position = points[r4];
-                m_polygon[p4].position = points[r3];
-
-                float dr1 = 1.f - m_fade * (sfu::magnitude(points[r2]-points[r1]) / m_range);
-                float dr2 = 1.f - m_fade * (sfu::magnitude(points[r4]-points[r3]) / m_range);
-                m_polygon[p1].color = m_polygon[p4].color = m_color;
-                m_polygon[p2].color = m_polygon[p3].color = m_color;
-                m_polygon[p2].color.a = m_color.a * dr1;
-                m_polygon[p3].color.a = m_color.a * dr2;
+                polygon[p1].position = points[r1];
+                polygon[p2].position = points[r2];
+                polygon[p3].position = points[r4];
+                polygon[p4].position = points[r3];
+            }
+            if(m_fade){
+                colorQuads<true>(polygon, m_color, m_range);
+            }else{
+                colorQuads<false>(polygon, m_color, m_range);
             }
         }
     }
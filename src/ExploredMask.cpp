@@ -0,0 +1,258 @@
+#include "Candle/ExploredMask.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Serialization.hpp"
+
+namespace candle{
+    /*
+     * Stream layout (little endian):
+     *   "CNDE" | version u16 | reserved u16 | width u32 | height u32 | runs...
+     * The cells, row by row, are stored as alternate runs of unexplored and
+     * explored cells, starting with an unexplored run (that may be empty).
+     * Each length is stored in 7 bits per byte, lowest first, with the high
+     * bit set in all the bytes but the last.
+     */
+    const char EXPLORED_MAGIC[4] = {'C', 'N', 'D', 'E'};
+    const sf::Uint16 EXPLORED_VERSION = 1;
+
+    void l_writeVarint(std::ostream& os, sf::Uint32 x){
+        while(x >= 0x80){
+            os.put((char)((x & 0x7F) | 0x80));
+            x >>= 7;
+        }
+        os.put((char)x);
+    }
+
+    bool l_readVarint(std::istream& is, sf::Uint32& x){
+        x = 0;
+        for(int shift = 0; shift < 35; shift += 7){
+            int c = is.get();
+            if(c == EOF) return false;
+            x |= (sf::Uint32)(c & 0x7F) << shift;
+            if(!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+    ExploredMask::ExploredMask(const sf::FloatRect& area, float cellSize)
+        : m_area(area)
+        , m_cellSize(cellSize)
+        , m_exploredCount(0)
+        , m_opacity(0.5f)
+        , m_quad(sf::Quads, 4)
+        , m_textureCreated(false)
+        {
+        m_size.x = std::max(1u, (unsigned int)std::ceil(area.width / cellSize));
+        m_size.y = std::max(1u, (unsigned int)std::ceil(area.height / cellSize));
+        m_image.create(m_size.x, m_size.y, sf::Color(255, 255, 255, 0));
+        float right = area.left + m_size.x * cellSize;
+        float bottom = area.top + m_size.y * cellSize;
+        m_quad[0].position = {area.left, area.top};
+        m_quad[1].position = {right, area.top};
+        m_quad[2].position = {right, bottom};
+        m_quad[3].position = {area.left, bottom};
+        m_quad[0].texCoords = {0.f, 0.f};
+        m_quad[1].texCoords = {(float)m_size.x, 0.f};
+        m_quad[2].texCoords = {(float)m_size.x, (float)m_size.y};
+        m_quad[3].texCoords = {0.f, (float)m_size.y};
+        setOpacity(m_opacity);
+    }
+
+    void ExploredMask::clear(){
+        m_image.create(m_size.x, m_size.y, sf::Color(255, 255, 255, 0));
+        m_exploredCount = 0;
+        m_dirty = sf::IntRect(0, 0, m_size.x, m_size.y);
+    }
+
+    void ExploredMask::markDirty(unsigned int x, unsigned int y){
+        if(m_dirty.width == 0){
+            m_dirty = sf::IntRect(x, y, 1, 1);
+            return;
+        }
+        int left = std::min(m_dirty.left, (int)x);
+        int top = std::min(m_dirty.top, (int)y);
+        int right = std::max(m_dirty.left + m_dirty.width, (int)x + 1);
+        int bottom = std::max(m_dirty.top + m_dirty.height, (int)y + 1);
+        m_dirty = sf::IntRect(left, top, right - left, bottom - top);
+    }
+
+    unsigned int ExploredMask::reveal(const VisionMask& vision){
+        sf::FloatRect bounds;
+        if(!vision.getGlobalBounds().intersects(m_area, bounds)){
+            return 0;
+        }
+        unsigned int x0 = (unsigned int)((bounds.left - m_area.left) / m_cellSize);
+        unsigned int y0 = (unsigned int)((bounds.top - m_area.top) / m_cellSize);
+        unsigned int x1 = std::min(m_size.x - 1, (unsigned int)((bounds.left + bounds.width - m_area.left) / m_cellSize));
+        unsigned int y1 = std::min(m_size.y - 1, (unsigned int)((bounds.top + bounds.height - m_area.top) / m_cellSize));
+        unsigned int revealed = 0;
+        for(unsigned int y = y0; y <= y1; y++){
+            for(unsigned int x = x0; x <= x1; x++){
+                if(m_image.getPixel(x, y).a != 0){
+                    continue;
+                }
+                sf::Vector2f center(m_area.left + (x + 0.5f) * m_cellSize,
+                                    m_area.top + (y + 0.5f) * m_cellSize);
+                if(vision.isVisible(center)){
+                    m_image.setPixel(x, y, sf::Color::White);
+                    markDirty(x, y);
+                    revealed++;
+                }
+            }
+        }
+        m_exploredCount += revealed;
+        return revealed;
+    }
+
+    unsigned int ExploredMask::reveal(const sf::Vector2f& center, float radius){
+        sf::FloatRect bounds;
+        if(!sf::FloatRect(center.x - radius, center.y - radius, radius*2, radius*2).intersects(m_area, bounds)){
+            return 0;
+        }
+        unsigned int x0 = (unsigned int)((bounds.left - m_area.left) / m_cellSize);
+        unsigned int y0 = (unsigned int)((bounds.top - m_area.top) / m_cellSize);
+        unsigned int x1 = std::min(m_size.x - 1, (unsigned int)((bounds.left + bounds.width - m_area.left) / m_cellSize));
+        unsigned int y1 = std::min(m_size.y - 1, (unsigned int)((bounds.top + bounds.height - m_area.top) / m_cellSize));
+        unsigned int revealed = 0;
+        for(unsigned int y = y0; y <= y1; y++){
+            for(unsigned int x = x0; x <= x1; x++){
+                float dx = m_area.left + (x + 0.5f) * m_cellSize - center.x;
+                float dy = m_area.top + (y + 0.5f) * m_cellSize - center.y;
+                if(dx*dx + dy*dy <= radius*radius && m_image.getPixel(x, y).a == 0){
+                    m_image.setPixel(x, y, sf::Color::White);
+                    markDirty(x, y);
+                    revealed++;
+                }
+            }
+        }
+        m_exploredCount += revealed;
+        return revealed;
+    }
+
+    bool ExploredMask::isExplored(const sf::Vector2f& point) const{
+        if(!m_area.contains(point)){
+            return false;
+        }
+        unsigned int x = std::min(m_size.x - 1, (unsigned int)((point.x - m_area.left) / m_cellSize));
+        unsigned int y = std::min(m_size.y - 1, (unsigned int)((point.y - m_area.top) / m_cellSize));
+        return m_image.getPixel(x, y).a != 0;
+    }
+
+    unsigned int ExploredMask::getExploredCount() const{
+        return m_exploredCount;
+    }
+
+    sf::Vector2u ExploredMask::getSize() const{
+        return m_size;
+    }
+
+    void ExploredMask::setOpacity(float opacity){
+        m_opacity = opacity;
+        sf::Color c(255, 255, 255, (sf::Uint8)(255 * opacity));
+        for(int i = 0; i < 4; i++){
+            m_quad[i].color = c;
+        }
+    }
+
+    float ExploredMask::getOpacity() const{
+        return m_opacity;
+    }
+
+    void ExploredMask::uploadDirty() const{
+        if(!m_textureCreated){
+            m_texture.create(m_size.x, m_size.y);
+            m_texture.setSmooth(true);
+            m_texture.update(m_image);
+            m_textureCreated = true;
+        }else if(m_dirty.width > 0){
+            // Copy the rows of the dirty rectangle to a contiguous buffer
+            const sf::Uint8* pixels = m_image.getPixelsPtr();
+            std::vector<sf::Uint8> buffer(m_dirty.width * m_dirty.height * 4);
+            for(int y = 0; y < m_dirty.height; y++){
+                std::memcpy(&buffer[y * m_dirty.width * 4],
+                            pixels + ((m_dirty.top + y) * m_size.x + m_dirty.left) * 4,
+                            m_dirty.width * 4);
+            }
+            m_texture.update(&buffer[0], m_dirty.width, m_dirty.height, m_dirty.left, m_dirty.top);
+        }
+        m_dirty = sf::IntRect();
+    }
+
+    void ExploredMask::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        uploadDirty();
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        st.texture = &m_texture;
+        t.draw(m_quad, st);
+    }
+
+    void ExploredMask::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        t.draw(m_quad, st, m_image);
+    }
+
+    bool ExploredMask::saveToStream(std::ostream& os) const{
+        os.write(EXPLORED_MAGIC, 4);
+        l_write(os, EXPLORED_VERSION, 2);
+        l_write(os, 0, 2);
+        l_write(os, m_size.x, 4);
+        l_write(os, m_size.y, 4);
+        const sf::Uint8* pixels = m_image.getPixelsPtr();
+        size_t n = m_size.x * m_size.y;
+        bool explored = false;
+        sf::Uint32 run = 0;
+        for(size_t i = 0; i < n; i++){
+            if((pixels[i*4 + 3] != 0) != explored){
+                l_writeVarint(os, run);
+                explored = !explored;
+                run = 0;
+            }
+            run++;
+        }
+        l_writeVarint(os, run);
+        return (bool)os;
+    }
+
+    bool ExploredMask::loadFromStream(std::istream& is){
+        char magic[4];
+        sf::Uint32 version, reserved, width, height;
+        if(!is.read(magic, 4) || std::memcmp(magic, EXPLORED_MAGIC, 4) != 0
+           || !l_read(is, version, 2) || version != EXPLORED_VERSION
+           || !l_read(is, reserved, 2)
+           || !l_read(is, width, 4) || width != m_size.x
+           || !l_read(is, height, 4) || height != m_size.y){
+            return false;
+        }
+        size_t n = width * height;
+        std::vector<sf::Uint8> cells(n, 0);
+        size_t i = 0;
+        bool explored = false;
+        while(i < n){
+            sf::Uint32 run;
+            if(!l_readVarint(is, run) || run > n - i){
+                return false;
+            }
+            std::fill(cells.begin() + i, cells.begin() + i + run, explored ? 255 : 0);
+            i += run;
+            explored = !explored;
+        }
+
+        m_exploredCount = 0;
+        for(unsigned int y = 0; y < height; y++){
+            for(unsigned int x = 0; x < width; x++){
+                sf::Uint8 a = cells[y * width + x];
+                m_image.setPixel(x, y, sf::Color(255, 255, 255, a));
+                m_exploredCount += a != 0;
+            }
+        }
+        m_dirty = sf::IntRect(0, 0, width, height);
+        return true;
+    }
+}
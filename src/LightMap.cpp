@@ -0,0 +1,181 @@
+#include "Candle/LightMap.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "Serialization.hpp"
+
+namespace candle{
+    /*
+     * File layout (little endian):
+     *   "CNDL" | version u16 | reserved u16 | width u32 | height u32 |
+     *   tile size u32 | tiles...
+     * Each tile, in row-major order, is:
+     *   encoding u8 | length u32 | length bytes of data
+     * with RAW data being the RGBA pixels of the tile and RLE data a
+     * sequence of runs of pixels: a header byte h < 128 followed by h+1
+     * literal pixels, or h >= 128 followed by a pixel repeated h-126 times.
+     */
+    const char LIGHTMAP_MAGIC[4] = {'C', 'N', 'D', 'L'};
+    const sf::Uint16 LIGHTMAP_VERSION = 1;
+    // Files that declare bigger images are rejected before allocating them
+    const sf::Uint32 LIGHTMAP_MAX_SIZE = 16384;
+    enum TileEncoding{
+        RAW = 0,
+        RLE = 1
+    };
+
+    void l_encodeRLE(const std::vector<sf::Uint32>& pixels, std::vector<sf::Uint8>& out){
+        size_t n = pixels.size();
+        size_t i = 0;
+        auto putPixel = [&out](sf::Uint32 p){
+            const sf::Uint8* b = reinterpret_cast<const sf::Uint8*>(&p);
+            out.insert(out.end(), b, b+4);
+        };
+        while(i < n){
+            size_t run = 1;
+            while(i + run < n && run < 129 && pixels[i + run] == pixels[i]){
+                run++;
+            }
+            if(run >= 2){
+                out.push_back((sf::Uint8)(run + 126));
+                putPixel(pixels[i]);
+                i += run;
+            }else{
+                size_t lit = 1;
+                while(i + lit < n && lit < 128
+                      && !(i + lit + 1 < n && pixels[i + lit] == pixels[i + lit + 1])){
+                    lit++;
+                }
+                out.push_back((sf::Uint8)(lit - 1));
+                for(size_t k = 0; k < lit; k++){
+                    putPixel(pixels[i + k]);
+                }
+                i += lit;
+            }
+        }
+    }
+
+    bool l_decodeRLE(const std::vector<sf::Uint8>& data, std::vector<sf::Uint32>& pixels){
+        size_t i = 0;
+        size_t p = 0;
+        while(i < data.size()){
+            sf::Uint8 h = data[i++];
+            size_t count = h < 128 ? h + 1 : h - 126;
+            size_t bytes = h < 128 ? count * 4 : 4;
+            if(i + bytes > data.size() || p + count > pixels.size()){
+                return false;
+            }
+            for(size_t k = 0; k < count; k++){
+                std::memcpy(&pixels[p++], &data[i + (h < 128 ? k*4 : 0)], 4);
+            }
+            i += bytes;
+        }
+        return p == pixels.size();
+    }
+
+    sf::Image bakeLightMap(LightingArea& area, EdgeVector& edges, const std::vector<LightSource*>& lights){
+        area.clear();
+        for(auto light: lights){
+            light->castLight(edges.begin(), edges.end());
+            area.draw(*light);
+        }
+        area.display();
+        return area.copyToImage();
+    }
+
+    bool saveLightMap(const sf::Image& image, const std::string& filename, bool compress, unsigned int tileSize){
+        std::ofstream os(filename, std::ios::binary);
+        if(!os || tileSize == 0){
+            return false;
+        }
+        sf::Vector2u size = image.getSize();
+        const sf::Uint8* src = image.getPixelsPtr();
+        os.write(LIGHTMAP_MAGIC, 4);
+        l_write(os, LIGHTMAP_VERSION, 2);
+        l_write(os, 0, 2);
+        l_write(os, size.x, 4);
+        l_write(os, size.y, 4);
+        l_write(os, tileSize, 4);
+
+        std::vector<sf::Uint32> tile;
+        std::vector<sf::Uint8> rle;
+        for(unsigned int ty = 0; ty < size.y; ty += tileSize){
+            for(unsigned int tx = 0; tx < size.x; tx += tileSize){
+                unsigned int w = std::min(tileSize, size.x - tx);
+                unsigned int h = std::min(tileSize, size.y - ty);
+                tile.resize(w * h);
+                for(unsigned int y = 0; y < h; y++){
+                    std::memcpy(&tile[y * w], src + ((ty + y) * size.x + tx) * 4, w * 4);
+                }
+                rle.clear();
+                if(compress){
+                    l_encodeRLE(tile, rle);
+                }
+                if(compress && rle.size() < tile.size() * 4){
+                    l_write(os, RLE, 1);
+                    l_write(os, rle.size(), 4);
+                    os.write(reinterpret_cast<const char*>(&rle[0]), rle.size());
+                }else{
+                    l_write(os, RAW, 1);
+                    l_write(os, tile.size() * 4, 4);
+                    os.write(reinterpret_cast<const char*>(&tile[0]), tile.size() * 4);
+                }
+            }
+        }
+        return (bool)os;
+    }
+
+    bool loadLightMap(sf::Image& image, const std::string& filename){
+        std::ifstream is(filename, std::ios::binary);
+        char magic[4];
+        if(!is.read(magic, 4) || std::memcmp(magic, LIGHTMAP_MAGIC, 4) != 0){
+            return false;
+        }
+        sf::Uint32 version, reserved, width, height, tileSize;
+        if(!l_read(is, version, 2) || version != LIGHTMAP_VERSION
+           || !l_read(is, reserved, 2)
+           || !l_read(is, width, 4)
+           || !l_read(is, height, 4)
+           || !l_read(is, tileSize, 4) || tileSize == 0
+           || width > LIGHTMAP_MAX_SIZE || height > LIGHTMAP_MAX_SIZE){
+            return false;
+        }
+        std::vector<sf::Uint8> pixels((size_t)width * height * 4);
+        std::vector<sf::Uint8> data;
+        std::vector<sf::Uint32> tile;
+        for(unsigned int ty = 0; ty < height; ty += tileSize){
+            for(unsigned int tx = 0; tx < width; tx += tileSize){
+                unsigned int w = std::min(tileSize, width - tx);
+                unsigned int h = std::min(tileSize, height - ty);
+                sf::Uint32 encoding, length;
+                if(!l_read(is, encoding, 1) || !l_read(is, length, 4)){
+                    return false;
+                }
+                // A RLE tile takes at most a header byte per pixel more
+                // than a raw one
+                if(length > (size_t)w * h * 5){
+                    return false;
+                }
+                data.resize(length);
+                if(length > 0 && !is.read(reinterpret_cast<char*>(&data[0]), length)){
+                    return false;
+                }
+                tile.resize(w * h);
+                if(encoding == RLE){
+                    if(!l_decodeRLE(data, tile)) return false;
+                }else if(encoding == RAW && length == (size_t)w * h * 4){
+                    std::memcpy(&tile[0], &data[0], length);
+                }else{
+                    return false;
+                }
+                for(unsigned int y = 0; y < h; y++){
+                    std::memcpy(&pixels[((size_t)(ty + y) * width + tx) * 4], &tile[y * w], w * 4);
+                }
+            }
+        }
+        image.create(width, height, pixels.empty() ? nullptr : &pixels[0]);
+        return true;
+    }
+}
@@ -0,0 +1,123 @@
+#include "Candle/LightParticles.hpp"
+
+#include "Candle/RadialLight.hpp"
+
+namespace candle{
+    LightParticles::LightParticles()
+        : m_vertices(sf::Quads)
+        , m_fade(true)
+        {}
+
+    void LightParticles::updateQuad(size_t i){
+        sf::Vector2f p = m_positions[i];
+        float r = m_ranges[i];
+        sf::Vertex* quad = &m_vertices[i*4];
+        quad[0].position = {p.x - r, p.y - r};
+        quad[1].position = {p.x + r, p.y - r};
+        quad[2].position = {p.x + r, p.y + r};
+        quad[3].position = {p.x - r, p.y + r};
+    }
+
+    size_t LightParticles::add(const sf::Vector2f& position, float range, const sf::Color& color, float intensity){
+        size_t i = m_positions.size();
+        m_positions.push_back(position);
+        m_ranges.push_back(range);
+
+        sf::FloatRect tr = RadialLight::getLightTextureRect();
+        sf::Color c(color.r, color.g, color.b, 255 * intensity);
+        m_vertices.append(sf::Vertex({}, c, {tr.left, tr.top}));
+        m_vertices.append(sf::Vertex({}, c, {tr.left + tr.width, tr.top}));
+        m_vertices.append(sf::Vertex({}, c, {tr.left + tr.width, tr.top + tr.height}));
+        m_vertices.append(sf::Vertex({}, c, {tr.left, tr.top + tr.height}));
+        updateQuad(i);
+        return i;
+    }
+
+    void LightParticles::remove(size_t i){
+        size_t last = m_positions.size() - 1;
+        m_positions[i] = m_positions[last];
+        m_ranges[i] = m_ranges[last];
+        for(int v = 0; v < 4; v++){
+            m_vertices[i*4 + v] = m_vertices[last*4 + v];
+        }
+        m_positions.pop_back();
+        m_ranges.pop_back();
+        m_vertices.resize(last*4);
+    }
+
+    void LightParticles::clear(){
+        m_positions.clear();
+        m_ranges.clear();
+        m_vertices.clear();
+    }
+
+    size_t LightParticles::getParticleCount() const{
+        return m_positions.size();
+    }
+
+    void LightParticles::setPosition(size_t i, const sf::Vector2f& position){
+        m_positions[i] = position;
+        updateQuad(i);
+    }
+
+    sf::Vector2f LightParticles::getPosition(size_t i) const{
+        return m_positions[i];
+    }
+
+    void LightParticles::setRange(size_t i, float range){
+        m_ranges[i] = range;
+        updateQuad(i);
+    }
+
+    float LightParticles::getRange(size_t i) const{
+        return m_ranges[i];
+    }
+
+    void LightParticles::setColor(size_t i, const sf::Color& color){
+        for(int v = 0; v < 4; v++){
+            sf::Color& c = m_vertices[i*4 + v].color;
+            c = {color.r, color.g, color.b, c.a};
+        }
+    }
+
+    sf::Color LightParticles::getColor(size_t i) const{
+        const sf::Color& c = m_vertices[i*4].color;
+        return {c.r, c.g, c.b, 255};
+    }
+
+    void LightParticles::setIntensity(size_t i, float intensity){
+        for(int v = 0; v < 4; v++){
+            m_vertices[i*4 + v].color.a = 255 * intensity;
+        }
+    }
+
+    float LightParticles::getIntensity(size_t i) const{
+        return (float)m_vertices[i*4].color.a/255.f;
+    }
+
+    void LightParticles::setFade(bool fade){
+        m_fade = fade;
+    }
+
+    bool LightParticles::getFade() const{
+        return m_fade;
+    }
+
+    void LightParticles::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        if(m_vertices.getVertexCount() == 0){
+            return;
+        }
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        st.texture = RadialLight::getLightTexture(m_fade);
+        t.draw(m_vertices, st);
+    }
+
+    void LightParticles::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        t.draw(m_vertices, st, RadialLight::getLightTextureFunction(m_fade));
+    }
+}
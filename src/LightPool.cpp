@@ -0,0 +1,293 @@
+#include "Candle/LightPool.hpp"
+
+namespace candle{
+    const int RADIAL_FADE = 0;
+    const int RADIAL_PLAIN = 1;
+    const int DIRECTED_ANY = 2;
+
+    template <typename T>
+    void removeRow(std::vector<T>& column, unsigned int i){
+        column[i] = column.back();
+        column.pop_back();
+    }
+
+    LightPool::LightPool(){
+        m_vertices[RADIAL_FADE].setPrimitiveType(sf::Triangles);
+        m_vertices[RADIAL_PLAIN].setPrimitiveType(sf::Triangles);
+        m_vertices[DIRECTED_ANY].setPrimitiveType(sf::Quads);
+    }
+
+    LightPool::Handle LightPool::create(Type type, float beam){
+        Handle light;
+        if(m_freeSlots.empty()){
+            light.slot = m_slots.size();
+            m_slots.push_back(Slot());
+            m_slots.back().generation = 0;
+        }else{
+            light.slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        Group& g = m_groups[type];
+        Slot& s = m_slots[light.slot];
+        s.type = type;
+        s.index = g.position.size();
+        light.generation = s.generation;
+
+        g.position.push_back(sf::Vector2f(0.f, 0.f));
+        g.rotation.push_back(0.f);
+        g.range.push_back(1.f);
+        g.beam.push_back(beam);
+        g.color.push_back(sf::Color::White);
+        g.fade.push_back(true);
+        g.changes.push_back(CAST);
+        g.slot.push_back(light.slot);
+        g.first.push_back(0);
+        g.count.push_back(0);
+        return light;
+    }
+
+    LightPool::Handle LightPool::createRadialLight(){
+        return create(RADIAL, 360.f);
+    }
+
+    LightPool::Handle LightPool::createDirectedLight(){
+        return create(DIRECTED, 10.f);
+    }
+
+    void LightPool::destroy(const Handle& light){
+        if(!isValid(light)){
+            return;
+        }
+        Slot& s = m_slots[light.slot];
+        Group& g = m_groups[s.type];
+        unsigned int i = s.index;
+        // The last light takes the place of the removed one
+        m_slots[g.slot.back()].index = i;
+        removeRow(g.position, i);
+        removeRow(g.rotation, i);
+        removeRow(g.range, i);
+        removeRow(g.beam, i);
+        removeRow(g.color, i);
+        removeRow(g.fade, i);
+        removeRow(g.changes, i);
+        removeRow(g.slot, i);
+        removeRow(g.first, i);
+        removeRow(g.count, i);
+        s.generation++;
+        m_freeSlots.push_back(light.slot);
+    }
+
+    bool LightPool::isValid(const Handle& light) const{
+        return light.slot < m_slots.size()
+            && m_slots[light.slot].generation == light.generation;
+    }
+
+    LightPool::Type LightPool::getType(const Handle& light) const{
+        return m_slots[light.slot].type;
+    }
+
+    size_t LightPool::getLightCount() const{
+        return m_groups[RADIAL].position.size() + m_groups[DIRECTED].position.size();
+    }
+
+    unsigned int LightPool::index(const Handle& light) const{
+        return m_slots[light.slot].index;
+    }
+
+    LightPool::Group& LightPool::group(const Handle& light){
+        return m_groups[m_slots[light.slot].type];
+    }
+
+    const LightPool::Group& LightPool::group(const Handle& light) const{
+        return m_groups[m_slots[light.slot].type];
+    }
+
+    void LightPool::setPosition(const Handle& light, const sf::Vector2f& position){
+        Group& g = group(light);
+        g.position[index(light)] = position;
+        g.changes[index(light)] |= CAST;
+    }
+
+    sf::Vector2f LightPool::getPosition(const Handle& light) const{
+        return group(light).position[index(light)];
+    }
+
+    void LightPool::setRotation(const Handle& light, float angle){
+        Group& g = group(light);
+        g.rotation[index(light)] = angle;
+        g.changes[index(light)] |= CAST;
+    }
+
+    float LightPool::getRotation(const Handle& light) const{
+        return group(light).rotation[index(light)];
+    }
+
+    void LightPool::setRange(const Handle& light, float range){
+        Group& g = group(light);
+        g.range[index(light)] = range;
+        g.changes[index(light)] |= CAST;
+    }
+
+    float LightPool::getRange(const Handle& light) const{
+        return group(light).range[index(light)];
+    }
+
+    void LightPool::setColor(const Handle& light, const sf::Color& color){
+        Group& g = group(light);
+        sf::Color& c = g.color[index(light)];
+        c = {color.r, color.g, color.b, c.a};
+        // The fade of directed lights is in the alpha of the vertices
+        g.changes[index(light)] |= getType(light) == RADIAL ? RECOLOR : CAST;
+    }
+
+    sf::Color LightPool::getColor(const Handle& light) const{
+        const sf::Color& c = group(light).color[index(light)];
+        return {c.r, c.g, c.b, 255};
+    }
+
+    void LightPool::setIntensity(const Handle& light, float intensity){
+        Group& g = group(light);
+        g.color[index(light)].a = 255 * intensity;
+        g.changes[index(light)] |= getType(light) == RADIAL ? RECOLOR : CAST;
+    }
+
+    float LightPool::getIntensity(const Handle& light) const{
+        return (float)group(light).color[index(light)].a/255.f;
+    }
+
+    void LightPool::setFade(const Handle& light, bool fade){
+        Group& g = group(light);
+        g.fade[index(light)] = fade;
+        g.changes[index(light)] |= CAST;
+    }
+
+    bool LightPool::getFade(const Handle& light) const{
+        return group(light).fade[index(light)];
+    }
+
+    void LightPool::setBeam(const Handle& light, float beam){
+        Group& g = group(light);
+        g.beam[index(light)] = beam;
+        g.changes[index(light)] |= CAST;
+    }
+
+    float LightPool::getBeam(const Handle& light) const{
+        return group(light).beam[index(light)];
+    }
+
+    void LightPool::invalidate(){
+        for(auto& g: m_groups){
+            for(auto& c: g.changes){
+                c |= CAST;
+            }
+        }
+    }
+
+    void LightPool::castRadial(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        Group& g = m_groups[RADIAL];
+        sf::VertexArray vertices[2] = {
+            sf::VertexArray(sf::Triangles),
+            sf::VertexArray(sf::Triangles)
+        };
+        sf::VertexArray polygon;
+        LightSource& caster = m_radialCaster;
+        for(unsigned int i = 0; i < g.position.size(); i++){
+            int kind = g.fade[i] ? RADIAL_FADE : RADIAL_PLAIN;
+            sf::VertexArray& out = vertices[kind];
+            unsigned int first = out.getVertexCount();
+            if(g.changes[i] & CAST){
+                m_radialCaster.setPosition(g.position[i]);
+                m_radialCaster.setRotation(g.rotation[i]);
+                m_radialCaster.setRange(g.range[i]);
+                m_radialCaster.setBeamAngle(g.beam[i]);
+                caster.castPolygon(begin, end, polygon);
+                sf::Transform trm = m_radialCaster.getPolygonTransform();
+                // The fan is split in triangles to merge it with the rest
+                for(unsigned int v = 2; v < polygon.getVertexCount(); v++){
+                    const sf::Vertex* fan[3] = {&polygon[0], &polygon[v-1], &polygon[v]};
+                    for(auto p: fan){
+                        out.append(sf::Vertex(trm.transformPoint(p->position), g.color[i], p->texCoords));
+                    }
+                }
+            }else{
+                const sf::VertexArray& previous = m_vertices[kind];
+                for(unsigned int v = g.first[i]; v < g.first[i] + g.count[i]; v++){
+                    out.append(previous[v]);
+                    if(g.changes[i] & RECOLOR){
+                        out[out.getVertexCount()-1].color = g.color[i];
+                    }
+                }
+            }
+            g.first[i] = first;
+            g.count[i] = out.getVertexCount() - first;
+            g.changes[i] = 0;
+        }
+        m_vertices[RADIAL_FADE] = vertices[RADIAL_FADE];
+        m_vertices[RADIAL_PLAIN] = vertices[RADIAL_PLAIN];
+    }
+
+    void LightPool::castDirected(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        Group& g = m_groups[DIRECTED];
+        sf::VertexArray out(sf::Quads);
+        sf::VertexArray polygon(sf::Quads);
+        LightSource& caster = m_directedCaster;
+        for(unsigned int i = 0; i < g.position.size(); i++){
+            unsigned int first = out.getVertexCount();
+            if(g.changes[i] & CAST){
+                m_directedCaster.setPosition(g.position[i]);
+                m_directedCaster.setRotation(g.rotation[i]);
+                m_directedCaster.setBeamWidth(g.beam[i]);
+                caster.m_range = g.range[i];
+                caster.m_color = g.color[i];
+                caster.m_fade = g.fade[i];
+                caster.castPolygon(begin, end, polygon);
+                sf::Transform trm = m_directedCaster.getTransform();
+                for(unsigned int v = 0; v < polygon.getVertexCount(); v++){
+                    sf::Vertex vertex = polygon[v];
+                    vertex.position = trm.transformPoint(vertex.position);
+                    out.append(vertex);
+                }
+            }else{
+                const sf::VertexArray& previous = m_vertices[DIRECTED_ANY];
+                for(unsigned int v = g.first[i]; v < g.first[i] + g.count[i]; v++){
+                    out.append(previous[v]);
+                }
+            }
+            g.first[i] = first;
+            g.count[i] = out.getVertexCount() - first;
+            g.changes[i] = 0;
+        }
+        m_vertices[DIRECTED_ANY] = out;
+    }
+
+    void LightPool::castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        castRadial(begin, end);
+        castDirected(begin, end);
+    }
+
+    void LightPool::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        for(int kind: {RADIAL_FADE, RADIAL_PLAIN}){
+            if(m_vertices[kind].getVertexCount() > 0){
+                sf::RenderStates radial(st);
+                radial.texture = RadialLight::getLightTexture(kind == RADIAL_FADE);
+                t.draw(m_vertices[kind], radial);
+            }
+        }
+        if(m_vertices[DIRECTED_ANY].getVertexCount() > 0){
+            t.draw(m_vertices[DIRECTED_ANY], st);
+        }
+    }
+
+    void LightPool::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        for(int kind: {RADIAL_FADE, RADIAL_PLAIN}){
+            t.draw(m_vertices[kind], st, RadialLight::getLightTextureFunction(kind == RADIAL_FADE));
+        }
+        t.draw(m_vertices[DIRECTED_ANY], st);
+    }
+}
@@ -0,0 +1,71 @@
+#include "Candle/LightSampler.hpp"
+
+#include <cmath>
+
+namespace candle{
+    LightSampler::LightSampler(float cellSize)
+        : m_cellSize(cellSize)
+        {}
+
+    unsigned long long LightSampler::getCellKey(int x, int y) const{
+        return ((unsigned long long)(unsigned int)x << 32) | (unsigned int)y;
+    }
+
+    void LightSampler::clear(){
+        m_lights.clear();
+        m_bounds.clear();
+        m_cells.clear();
+    }
+
+    void LightSampler::addLight(const LightSource& light){
+        unsigned int index = m_lights.size();
+        m_lights.push_back(&light);
+        sf::FloatRect bounds = light.getGlobalBounds();
+        m_bounds.push_back(bounds);
+        int x0 = (int)std::floor(bounds.left / m_cellSize);
+        int y0 = (int)std::floor(bounds.top / m_cellSize);
+        int x1 = (int)std::floor((bounds.left + bounds.width) / m_cellSize);
+        int y1 = (int)std::floor((bounds.top + bounds.height) / m_cellSize);
+        for(int x = x0; x <= x1; x++){
+            for(int y = y0; y <= y1; y++){
+                m_cells[getCellKey(x, y)].push_back(index);
+            }
+        }
+    }
+
+    size_t LightSampler::getLightCount() const{
+        return m_lights.size();
+    }
+
+    LightSample LightSampler::sample(const sf::Vector2f& point) const{
+        LightSample s;
+        s.color = sf::Vector3f(0.f, 0.f, 0.f);
+        s.intensity = 0.f;
+        auto cell = m_cells.find(getCellKey((int)std::floor(point.x / m_cellSize),
+                                            (int)std::floor(point.y / m_cellSize)));
+        if(cell == m_cells.end()){
+            return s;
+        }
+        for(unsigned int i: cell->second){
+            if(!m_bounds[i].contains(point)){
+                continue;
+            }
+            const LightSource& light = *m_lights[i];
+            float illumination = light.getIllumination(point);
+            if(illumination > 0.f){
+                sf::Color c = light.getColor();
+                s.color += sf::Vector3f(c.r, c.g, c.b) * (illumination / 255.f);
+                s.intensity += illumination;
+            }
+        }
+        return s;
+    }
+
+    void LightSampler::sample(const std::vector<sf::Vector2f>& points,
+                              std::vector<LightSample>& samples) const{
+        samples.resize(points.size());
+        for(size_t i = 0; i < points.size(); i++){
+            samples[i] = sample(points[i]);
+        }
+    }
+}
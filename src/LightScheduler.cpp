@@ -0,0 +1,115 @@
+#include "Candle/LightScheduler.hpp"
+
+#include <algorithm>
+
+#include "Candle/Culling.hpp"
+#include "Candle/geometry/Vector2.hpp"
+
+namespace candle{
+    LightScheduler::LightScheduler()
+        : m_sizeWeight(1.f)
+        , m_distanceWeight(1.f)
+        , m_stalenessWeight(0.1f)
+        , m_costMeasured(false)
+        {}
+
+    void LightScheduler::setCamera(const sf::View& view){
+        m_viewBounds = getViewBounds(view);
+    }
+
+    void LightScheduler::setWeights(float size, float distance, float staleness){
+        m_sizeWeight = size;
+        m_distanceWeight = distance;
+        m_stalenessWeight = staleness;
+    }
+
+    void LightScheduler::schedule(LightSource& light){
+        if(!m_index.emplace(&light, m_pending.size()).second){
+            return;
+        }
+        Entry entry;
+        entry.light = &light;
+        entry.frames = 0;
+        entry.priority = 0.f;
+        m_pending.push_back(entry);
+    }
+
+    void LightScheduler::unschedule(const LightSource& light){
+        auto it = m_index.find(&light);
+        if(it == m_index.end()){
+            return;
+        }
+        // The order doesn't matter until the next update sorts the entries,
+        // so the last one takes the place of the removed one
+        size_t i = it->second;
+        m_index.erase(it);
+        if(i + 1 < m_pending.size()){
+            m_pending[i] = m_pending.back();
+            m_index[m_pending[i].light] = i;
+        }
+        m_pending.pop_back();
+    }
+
+    size_t LightScheduler::getPendingCount() const{
+        return m_pending.size();
+    }
+
+    sf::Time LightScheduler::getAverageCastTime() const{
+        return m_averageCost;
+    }
+
+    float LightScheduler::computePriority(const Entry& entry) const{
+        float priority = m_stalenessWeight * entry.frames;
+        float viewArea = m_viewBounds.width * m_viewBounds.height;
+        if(viewArea <= 0.f){
+            return priority;
+        }
+        sf::FloatRect bounds = entry.light->getGlobalBounds();
+        sf::FloatRect visible;
+        if(bounds.intersects(m_viewBounds, visible)){
+            priority += m_sizeWeight * visible.width * visible.height / viewArea;
+        }
+        sf::Vector2f center(bounds.left + bounds.width/2.f, bounds.top + bounds.height/2.f);
+        sf::Vector2f viewCenter(m_viewBounds.left + m_viewBounds.width/2.f, m_viewBounds.top + m_viewBounds.height/2.f);
+        float diagonal = sfu::magnitude(sf::Vector2f(m_viewBounds.width, m_viewBounds.height));
+        priority += m_distanceWeight * (1.f - std::min(1.f, sfu::magnitude(center - viewCenter) / diagonal));
+        return priority;
+    }
+
+    size_t LightScheduler::update(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::Time budget){
+        for(auto& entry: m_pending){
+            entry.priority = computePriority(entry);
+        }
+        std::sort(m_pending.begin(), m_pending.end(), [](const Entry& a, const Entry& b){
+            return a.priority > b.priority;
+        });
+
+        sf::Clock clock;
+        size_t casted = 0;
+        while(casted < m_pending.size()){
+            sf::Time spent = clock.getElapsedTime();
+            if(casted > 0 && spent + m_averageCost > budget){
+                break;
+            }
+            m_pending[casted].light->castLight(begin, end);
+            casted++;
+            sf::Time cost = clock.getElapsedTime() - spent;
+            if(m_costMeasured){
+                // Exponential moving average of the cost of a cast
+                m_averageCost = sf::microseconds((m_averageCost.asMicroseconds() * 7 + cost.asMicroseconds()) / 8);
+            }else{
+                m_averageCost = cost;
+                m_costMeasured = true;
+            }
+        }
+        for(size_t i = 0; i < casted; i++){
+            m_index.erase(m_pending[i].light);
+        }
+        m_pending.erase(m_pending.begin(), m_pending.begin() + casted);
+        for(size_t i = 0; i < m_pending.size(); i++){
+            m_pending[i].frames++;
+            m_index[m_pending[i].light] = i;
+        }
+        return casted;
+    }
+}
@@ -0,0 +1,63 @@
+#include "Candle/LightSet.hpp"
+
+#include <algorithm>
+
+namespace candle{
+    void LightSet::add(LightSource& light){
+        m_lights.push_back(&light);
+        m_bounds.push_back(sf::FloatRect());
+    }
+
+    bool LightSet::remove(const LightSource& light){
+        auto it = std::find(m_lights.begin(), m_lights.end(), &light);
+        if(it == m_lights.end()){
+            return false;
+        }
+        size_t i = it - m_lights.begin();
+        m_lights.erase(it);
+        m_bounds.erase(m_bounds.begin() + i);
+        return true;
+    }
+
+    void LightSet::clear(){
+        m_lights.clear();
+        m_bounds.clear();
+    }
+
+    size_t LightSet::getLightCount() const{
+        return m_lights.size();
+    }
+
+    unsigned int LightSet::castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        for(size_t i = 0; i < m_lights.size(); i++){
+            m_lights[i]->castLight(begin, end);
+            m_bounds[i] = m_lights[i]->getGlobalBounds();
+        }
+        return m_lights.size();
+    }
+
+    unsigned int LightSet::castLights(const EdgeVector::iterator& begin,
+                                      const EdgeVector::iterator& end,
+                                      const std::vector<sf::FloatRect>& regions){
+        unsigned int casted = 0;
+        for(size_t i = 0; i < m_lights.size(); i++){
+            sf::FloatRect bounds = m_lights[i]->getGlobalBounds();
+            bool seen = false;
+            for(auto& r: regions){
+                if(bounds.intersects(r)){
+                    seen = true;
+                    break;
+                }
+            }
+            if(seen){
+                m_lights[i]->castLight(begin, end);
+                m_bounds[i] = bounds;
+                casted++;
+            }else{
+                // Culled in every area until it is casted again
+                m_bounds[i] = sf::FloatRect();
+            }
+        }
+        return casted;
+    }
+}
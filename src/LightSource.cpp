@@ -9,13 +9,33 @@
 
 namespace candle{
     LightSource::LightSource()
-        : m_color(sf::Color::White)
+        : m_asyncType(nullptr)
+        , m_legacyCast(false)
+#ifdef CANDLE_DEBUG
+        , m_backDebug(sf::Lines, 0)
+#endif
+        , m_color(sf::Color::White)
+        , m_range(1.f)
         , m_fade(true)
 #ifdef CANDLE_DEBUG
         , m_debug(sf::Lines, 0)
 #endif
         {}
     
+    LightSource::~LightSource(){
+        waitForCast();
+    }
+    
+    void LightSource::waitForCast(){
+        if(m_pendingCast.valid()){
+            m_pendingCast.wait();
+        }
+    }
+    
+    void LightSource::allowAsyncCast(const std::type_info& type){
+        m_asyncType = &type;
+    }
+    
     void LightSource::setIntensity(float intensity){
         m_color.a = 255 * intensity;
         resetColor();
@@ -52,4 +72,85 @@ namespace candle{
         return m_range;
     }
     
+    sf::FloatRect LightSource::getLocalBounds() const{
+        return sf::FloatRect(-m_range, -m_range, m_range*2, m_range*2);
+    }
+    
+    sf::FloatRect LightSource::getGlobalBounds() const{
+        return Transformable::getTransform().transformRect(getLocalBounds());
+    }
+    
+    void LightSource::castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        // Reached from castPolygon if the subclass overrides neither
+        if(m_legacyCast){
+            return;
+        }
+        castPolygon(begin, end, m_polygon);
+    }
+    
+    void LightSource::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon){
+        // Subclasses that only override castLight write to m_polygon
+        m_legacyCast = true;
+        castLight(begin, end);
+        m_legacyCast = false;
+        if(&polygon != &m_polygon){
+            polygon = m_polygon;
+        }
+    }
+    
+    void LightSource::castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd){
+        castPolygon(begin, end, capsulesBegin, capsulesEnd, m_polygon);
+    }
+    
+    void LightSource::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                  const CapsuleVector::iterator&, const CapsuleVector::iterator&,
+                                  sf::VertexArray& polygon){
+        castPolygon(begin, end, polygon);
+    }
+    
+    std::shared_future<void> LightSource::castLightAsync(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, std::launch policy){
+        waitForCast();
+        // Update the cached transform here, so the worker only reads it
+        Transformable::getTransform();
+        m_backPolygon.setPrimitiveType(m_polygon.getPrimitiveType());
+        if(m_asyncType == nullptr || typeid(*this) != *m_asyncType){
+            castPolygon(begin, end, m_backPolygon);
+            m_pendingCast = std::async(std::launch::deferred, [](){}).share();
+            return m_pendingCast;
+        }
+        EdgeVector::iterator b = begin, e = end;
+        m_pendingCast = std::async(policy, [this, b, e](){
+            castPolygon(b, e, m_backPolygon);
+        }).share();
+        return m_pendingCast;
+    }
+    
+    bool LightSource::swapPolygon(){
+        if(!m_pendingCast.valid()){
+            return false;
+        }
+        m_pendingCast.get();
+        m_pendingCast = std::shared_future<void>();
+        std::swap(m_polygon, m_backPolygon);
+#ifdef CANDLE_DEBUG
+        std::swap(m_debug, m_backDebug);
+#endif
+        // The color may have changed during the cast
+        resetColor();
+        return true;
+    }
+    
+#ifdef CANDLE_DEBUG
+    sf::VertexArray& LightSource::getDebugLines(const sf::VertexArray& polygon){
+        return &polygon == &m_backPolygon ? m_backDebug : m_debug;
+    }
+#endif
+    
+    void LightSource::rasterize(sfu::SoftwareTarget&, sf::RenderStates) const{}
+    
+    float LightSource::getIllumination(const sf::Vector2f&) const{
+        return 0.f;
+    }
+    
 }
@@ -0,0 +1,369 @@
+#include "Candle/LightTree.hpp"
+
+#include <algorithm>
+
+namespace candle{
+    namespace{
+        sf::FloatRect merge(const sf::FloatRect& a, const sf::FloatRect& b){
+            float left = std::min(a.left, b.left);
+            float top = std::min(a.top, b.top);
+            float right = std::max(a.left + a.width, b.left + b.width);
+            float bottom = std::max(a.top + a.height, b.top + b.height);
+            return sf::FloatRect(left, top, right - left, bottom - top);
+        }
+
+        float perimeter(const sf::FloatRect& r){
+            return 2.f * (r.width + r.height);
+        }
+
+        bool containsRect(const sf::FloatRect& outer, const sf::FloatRect& inner){
+            return inner.left >= outer.left
+                && inner.top >= outer.top
+                && inner.left + inner.width <= outer.left + outer.width
+                && inner.top + inner.height <= outer.top + outer.height;
+        }
+
+        bool overlaps(const sf::FloatRect& a, const sf::FloatRect& b){
+            return a.left <= b.left + b.width && b.left <= a.left + a.width
+                && a.top <= b.top + b.height && b.top <= a.top + a.height;
+        }
+
+        bool containsPoint(const sf::FloatRect& r, const sf::Vector2f& p){
+            return p.x >= r.left && p.x <= r.left + r.width
+                && p.y >= r.top && p.y <= r.top + r.height;
+        }
+    }
+
+    LightTree::LightTree(float margin)
+        : m_root(-1)
+        , m_margin(margin)
+        {}
+
+    int LightTree::allocateNode(){
+        int node;
+        if(m_freeNodes.empty()){
+            node = m_nodes.size();
+            m_nodes.emplace_back();
+        }else{
+            node = m_freeNodes.back();
+            m_freeNodes.pop_back();
+        }
+        Node& n = m_nodes[node];
+        n.light = nullptr;
+        n.parent = n.left = n.right = -1;
+        n.height = 0;
+        return node;
+    }
+
+    void LightTree::freeNode(int node){
+        m_nodes[node].light = nullptr;
+        m_freeNodes.push_back(node);
+    }
+
+    void LightTree::setLeafBounds(int leaf){
+        Node& n = m_nodes[leaf];
+        n.bounds = n.light->getGlobalBounds();
+        n.box = sf::FloatRect(n.bounds.left - m_margin,
+                              n.bounds.top - m_margin,
+                              n.bounds.width + 2.f * m_margin,
+                              n.bounds.height + 2.f * m_margin);
+    }
+
+    void LightTree::insertLeaf(int leaf){
+        if(m_root == -1){
+            m_root = leaf;
+            m_nodes[leaf].parent = -1;
+            return;
+        }
+
+        // Descend to the sibling that enlarges the tree the least
+        const sf::FloatRect box = m_nodes[leaf].box;
+        int index = m_root;
+        while(m_nodes[index].left != -1){
+            const Node& n = m_nodes[index];
+            float area = perimeter(n.box);
+            float combined = perimeter(merge(n.box, box));
+            float cost = 2.f * combined;
+            float inheritance = 2.f * (combined - area);
+            auto childCost = [&](int child){
+                const Node& c = m_nodes[child];
+                float enlarged = perimeter(merge(c.box, box));
+                if(c.left != -1){
+                    enlarged -= perimeter(c.box);
+                }
+                return enlarged + inheritance;
+            };
+            float costLeft = childCost(n.left);
+            float costRight = childCost(n.right);
+            if(cost < costLeft && cost < costRight){
+                break;
+            }
+            index = costLeft < costRight ? n.left : n.right;
+        }
+
+        int sibling = index;
+        int oldParent = m_nodes[sibling].parent;
+        int newParent = allocateNode();
+        Node& p = m_nodes[newParent];
+        p.parent = oldParent;
+        p.box = merge(box, m_nodes[sibling].box);
+        p.height = m_nodes[sibling].height + 1;
+        p.left = sibling;
+        p.right = leaf;
+        if(oldParent != -1){
+            Node& op = m_nodes[oldParent];
+            if(op.left == sibling){
+                op.left = newParent;
+            }else{
+                op.right = newParent;
+            }
+        }else{
+            m_root = newParent;
+        }
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent = newParent;
+
+        refit(m_nodes[leaf].parent);
+    }
+
+    void LightTree::removeLeaf(int leaf){
+        if(leaf == m_root){
+            m_root = -1;
+            return;
+        }
+        int parent = m_nodes[leaf].parent;
+        int grandParent = m_nodes[parent].parent;
+        int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+        if(grandParent != -1){
+            Node& g = m_nodes[grandParent];
+            if(g.left == parent){
+                g.left = sibling;
+            }else{
+                g.right = sibling;
+            }
+            m_nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refit(grandParent);
+        }else{
+            m_root = sibling;
+            m_nodes[sibling].parent = -1;
+            freeNode(parent);
+        }
+    }
+
+    void LightTree::refit(int node){
+        // Walk up to the root, balancing and fixing the boxes and heights
+        while(node != -1){
+            node = balance(node);
+            Node& n = m_nodes[node];
+            const Node& l = m_nodes[n.left];
+            const Node& r = m_nodes[n.right];
+            n.height = 1 + std::max(l.height, r.height);
+            n.box = merge(l.box, r.box);
+            node = n.parent;
+        }
+    }
+
+    int LightTree::balance(int a){
+        Node& A = m_nodes[a];
+        if(A.left == -1 || A.height < 2){
+            return a;
+        }
+        int b = A.left;
+        int c = A.right;
+        Node& B = m_nodes[b];
+        Node& C = m_nodes[c];
+        int diff = C.height - B.height;
+        if(diff > 1){
+            // Rotate C up
+            int f = C.left;
+            int g = C.right;
+            Node& F = m_nodes[f];
+            Node& G = m_nodes[g];
+            C.left = a;
+            C.parent = A.parent;
+            A.parent = c;
+            if(C.parent != -1){
+                Node& P = m_nodes[C.parent];
+                if(P.left == a){
+                    P.left = c;
+                }else{
+                    P.right = c;
+                }
+            }else{
+                m_root = c;
+            }
+            if(F.height > G.height){
+                C.right = f;
+                A.right = g;
+                G.parent = a;
+                A.box = merge(B.box, G.box);
+                C.box = merge(A.box, F.box);
+                A.height = 1 + std::max(B.height, G.height);
+                C.height = 1 + std::max(A.height, F.height);
+            }else{
+                C.right = g;
+                A.right = f;
+                F.parent = a;
+                A.box = merge(B.box, F.box);
+                C.box = merge(A.box, G.box);
+                A.height = 1 + std::max(B.height, F.height);
+                C.height = 1 + std::max(A.height, G.height);
+            }
+            return c;
+        }
+        if(diff < -1){
+            // Rotate B up
+            int d = B.left;
+            int e = B.right;
+            Node& D = m_nodes[d];
+            Node& E = m_nodes[e];
+            B.left = a;
+            B.parent = A.parent;
+            A.parent = b;
+            if(B.parent != -1){
+                Node& P = m_nodes[B.parent];
+                if(P.left == a){
+                    P.left = b;
+                }else{
+                    P.right = b;
+                }
+            }else{
+                m_root = b;
+            }
+            if(D.height > E.height){
+                B.right = d;
+                A.left = e;
+                E.parent = a;
+                A.box = merge(C.box, E.box);
+                B.box = merge(A.box, D.box);
+                A.height = 1 + std::max(C.height, E.height);
+                B.height = 1 + std::max(A.height, D.height);
+            }else{
+                B.right = e;
+                A.left = d;
+                D.parent = a;
+                A.box = merge(C.box, D.box);
+                B.box = merge(A.box, E.box);
+                A.height = 1 + std::max(C.height, D.height);
+                B.height = 1 + std::max(A.height, E.height);
+            }
+            return b;
+        }
+        return a;
+    }
+
+    void LightTree::insert(LightSource& light){
+        auto it = m_leaves.find(&light);
+        if(it != m_leaves.end()){
+            update(light);
+            return;
+        }
+        int leaf = allocateNode();
+        m_nodes[leaf].light = &light;
+        setLeafBounds(leaf);
+        insertLeaf(leaf);
+        m_leaves[&light] = leaf;
+    }
+
+    bool LightTree::remove(const LightSource& light){
+        auto it = m_leaves.find(&light);
+        if(it == m_leaves.end()){
+            return false;
+        }
+        removeLeaf(it->second);
+        freeNode(it->second);
+        m_leaves.erase(it);
+        return true;
+    }
+
+    void LightTree::clear(){
+        m_nodes.clear();
+        m_freeNodes.clear();
+        m_leaves.clear();
+        m_root = -1;
+    }
+
+    bool LightTree::contains(const LightSource& light) const{
+        return m_leaves.count(&light) > 0;
+    }
+
+    size_t LightTree::getLightCount() const{
+        return m_leaves.size();
+    }
+
+    unsigned int LightTree::update(){
+        unsigned int moved = 0;
+        for(auto& entry: m_leaves){
+            int leaf = entry.second;
+            Node& n = m_nodes[leaf];
+            n.bounds = n.light->getGlobalBounds();
+            // Move the leaf if it left its box, or if it shrank so much that
+            // the box is too loose
+            if(!containsRect(n.box, n.bounds) ||
+               n.box.width > n.bounds.width + 4.f * m_margin ||
+               n.box.height > n.bounds.height + 4.f * m_margin){
+                removeLeaf(leaf);
+                setLeafBounds(leaf);
+                insertLeaf(leaf);
+                moved++;
+            }
+        }
+        return moved;
+    }
+
+    void LightTree::update(const LightSource& light){
+        auto it = m_leaves.find(&light);
+        if(it == m_leaves.end()){
+            return;
+        }
+        int leaf = it->second;
+        removeLeaf(leaf);
+        setLeafBounds(leaf);
+        insertLeaf(leaf);
+    }
+
+    void LightTree::query(const sf::FloatRect& region, std::vector<LightSource*>& lights) const{
+        if(m_root == -1){
+            return;
+        }
+        std::vector<int> stack(1, m_root);
+        while(!stack.empty()){
+            const Node& n = m_nodes[stack.back()];
+            stack.pop_back();
+            if(!overlaps(n.box, region)){
+                continue;
+            }
+            if(n.left == -1){
+                if(overlaps(n.bounds, region)){
+                    lights.push_back(n.light);
+                }
+            }else{
+                stack.push_back(n.left);
+                stack.push_back(n.right);
+            }
+        }
+    }
+
+    void LightTree::query(const sf::Vector2f& point, std::vector<LightSource*>& lights) const{
+        if(m_root == -1){
+            return;
+        }
+        std::vector<int> stack(1, m_root);
+        while(!stack.empty()){
+            const Node& n = m_nodes[stack.back()];
+            stack.pop_back();
+            if(!containsPoint(n.box, point)){
+                continue;
+            }
+            if(n.left == -1){
+                if(containsPoint(n.bounds, point)){
+                    lights.push_back(n.light);
+                }
+            }else{
+                stack.push_back(n.left);
+                stack.push_back(n.right);
+            }
+        }
+    }
+}
@@ -1,4 +1,8 @@
 #include "Candle/LightingArea.hpp"
+
+#include <algorithm>
+#include <cmath>
+
 #include "Candle/graphics/VertexArray.hpp"
 
 
@@ -13,44 +17,68 @@ namespace candle{
         sf::BlendMode::Equation::Add    );            // alpha eq
     
     void LightingArea::initializeRenderTexture(const sf::Vector2f& size){
-        m_renderTexture.create(size.x, size.y);
-        m_renderTexture.setSmooth(true);
+        m_size = size;
+        // The lights are rendered at the scaled resolution and upsampled
+        // when the area is drawn
+        sf::Vector2f scaled(
+            std::max(1.f, std::ceil(size.x * m_resolutionScale)),
+            std::max(1.f, std::ceil(size.y * m_resolutionScale)));
+        if(m_backend == SOFTWARE){
+            m_softwareTarget.create(scaled.x, scaled.y);
+            m_softwareTextureOutdated = true;
+        }else{
+            m_renderTexture.create(scaled.x, scaled.y);
+            m_renderTexture.setSmooth(true);
+        }
+        m_staticLayerOutdated = true;
+        m_areaQuad[0].position = {0, 0};
+        m_areaQuad[1].position = {size.x, 0};
+        m_areaQuad[2].position = {size.x, size.y};
+        m_areaQuad[3].position = {0, size.y};
         m_baseTextureQuad[0].position =
-        m_areaQuad[0].position =
         m_areaQuad[0].texCoords = {0, 0};
         m_baseTextureQuad[1].position =
-        m_areaQuad[1].position =
-        m_areaQuad[1].texCoords = {size.x, 0};
+        m_areaQuad[1].texCoords = {scaled.x, 0};
         m_baseTextureQuad[2].position =
-        m_areaQuad[2].position =
-        m_areaQuad[2].texCoords = {size.x, size.y};
+        m_areaQuad[2].texCoords = {scaled.x, scaled.y};
         m_baseTextureQuad[3].position =
-        m_areaQuad[3].position =
-        m_areaQuad[3].texCoords = {0, size.y};
+        m_areaQuad[3].texCoords = {0, scaled.y};
     }
     
-    LightingArea::LightingArea(Mode mode, const sf::Vector2f& position, const sf::Vector2f& size)
+    LightingArea::LightingArea(Mode mode, const sf::Vector2f& position, const sf::Vector2f& size, Backend backend)
     : m_baseTextureQuad(sf::Quads, 4)
+    , m_softwareTextureOutdated(true)
+    , m_backend(backend)
     , m_areaQuad(sf::Quads, 4)
     , m_color(sf::Color::White)
     {
         m_opacity = 1.f;
+        m_resolutionScale = 1.f;
         m_mode = mode;
         m_baseTexture = nullptr;
+        m_staticLayerOutdated = true;
         initializeRenderTexture(size);
         Transformable::setPosition(position);
     }
     
-    LightingArea::LightingArea(Mode mode, const sf::Texture* t, sf::IntRect r)
+    LightingArea::LightingArea(Mode mode, const sf::Texture* t, sf::IntRect r, Backend backend)
     : m_baseTextureQuad(sf::Quads, 4)
+    , m_softwareTextureOutdated(true)
+    , m_backend(backend)
     , m_areaQuad(sf::Quads, 4)
     , m_color(sf::Color::White)
     {
         m_opacity = 1.f;
+        m_resolutionScale = 1.f;
         m_mode = mode;
+        m_staticLayerOutdated = true;
         setAreaTexture(t, r);
     }
     
+    LightingArea::Backend LightingArea::getBackend() const{
+        return m_backend;
+    }
+    
     sf::FloatRect LightingArea::getLocalBounds () const{
         return m_areaQuad.getBounds();
     }
@@ -65,13 +93,95 @@ namespace candle{
                 s.blendMode = sf::BlendAdd;
             }
             s.transform *= Transformable::getTransform();
-            s.texture = &m_renderTexture.getTexture();
+            if(m_backend == SOFTWARE){
+                if(m_softwareTextureOutdated){
+                    m_softwareTexture.loadFromImage(m_softwareTarget.copyToImage());
+                    m_softwareTexture.setSmooth(true);
+                    m_softwareTextureOutdated = false;
+                }
+                s.texture = &m_softwareTexture;
+            }else{
+                s.texture = &m_renderTexture.getTexture();
+            }
             t.draw(m_areaQuad, s);
         }
     }
     
     void LightingArea::clear(){
-        if(m_baseTexture != nullptr){
+        // Lights are only drawn in FOG mode, so in AMBIENT mode the static
+        // layer would be the same as the base
+        if(m_staticLights.empty() || m_mode != FOG){
+            clearBase();
+            return;
+        }
+        const float* m1 = m_staticLayerTransform.getMatrix();
+        const float* m2 = Transformable::getTransform().getMatrix();
+        if(m_staticLayerOutdated || !std::equal(m1, m1 + 16, m2)){
+            updateStaticLayer();
+        }
+        if(m_backend == SOFTWARE){
+            m_softwareTarget = m_staticSoftwareLayer;
+        }else{
+            m_renderTexture.clear(sf::Color::Transparent);
+            m_renderTexture.draw(sf::Sprite(m_staticLayer), sf::BlendNone);
+        }
+    }
+    
+    void LightingArea::updateStaticLayer(){
+        clearBase();
+        for(auto light: m_staticLights){
+            draw(*light);
+        }
+        if(m_backend == SOFTWARE){
+            m_staticSoftwareLayer = m_softwareTarget;
+        }else{
+            m_renderTexture.display();
+            sf::Vector2u size = m_renderTexture.getSize();
+            if(m_staticLayer.getSize() != size){
+                m_staticLayer.create(size.x, size.y);
+            }
+            m_staticLayer.update(m_renderTexture.getTexture());
+        }
+        m_staticLayerTransform = Transformable::getTransform();
+        m_staticLayerOutdated = false;
+    }
+    
+    void LightingArea::addStaticLight(const LightSource& light){
+        m_staticLights.push_back(&light);
+        m_staticLayerOutdated = true;
+    }
+    
+    void LightingArea::removeStaticLight(const LightSource& light){
+        auto it = std::find(m_staticLights.begin(), m_staticLights.end(), &light);
+        if(it != m_staticLights.end()){
+            m_staticLights.erase(it);
+            m_staticLayerOutdated = true;
+        }
+    }
+    
+    void LightingArea::invalidateStaticLayer(){
+        m_staticLayerOutdated = true;
+    }
+    
+    bool LightingArea::invalidateStaticLayer(const sf::FloatRect& region){
+        for(auto light: m_staticLights){
+            if(light->getGlobalBounds().intersects(region)){
+                m_staticLayerOutdated = true;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void LightingArea::clearBase(){
+        if(m_backend == SOFTWARE){
+            if(m_baseImage.getSize().x != 0){
+                m_softwareTarget.clear(sf::Color::Transparent);
+                m_softwareTarget.draw(m_baseTextureQuad, sf::RenderStates::Default, m_baseImage);
+            }else{
+                m_softwareTarget.clear(getActualColor());
+            }
+        }else if(m_baseTexture != nullptr){
             m_renderTexture.clear(sf::Color::Transparent);
             m_renderTexture.draw(m_baseTextureQuad, m_baseTexture);
         }else{
@@ -81,6 +191,7 @@ namespace candle{
     
     void LightingArea::setAreaColor(sf::Color c){
         m_color = c;
+        m_staticLayerOutdated = true;
         sfu::setColor(m_baseTextureQuad, getActualColor());
     }
     
@@ -96,6 +207,7 @@ namespace candle{
     
     void LightingArea::setAreaOpacity(float o){
         m_opacity = o;
+        m_staticLayerOutdated = true;
         sfu::setColor(m_baseTextureQuad, getActualColor());
     }
     
@@ -103,17 +215,124 @@ namespace candle{
     return m_opacity;
     }
     
+    sf::RenderStates LightingArea::getFogStates() const{
+        sf::RenderStates fogrs;
+        fogrs.blendMode = l_substractAlpha;
+        fogrs.transform.scale(m_resolutionScale, m_resolutionScale);
+        fogrs.transform *= Transformable::getTransform().getInverse();
+        return fogrs;
+    }
+    
     void LightingArea::draw(const LightSource& light){
+        if(m_opacity > 0.f && m_mode == FOG && cull(light) != HIDDEN){
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                light.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(light, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::draw(const LightPool& pool){
+        if(m_opacity > 0.f && m_mode == FOG){
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                pool.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(pool, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::draw(const LightParticles& particles){
+        if(m_opacity > 0.f && m_mode == FOG){
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                particles.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(particles, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::draw(const VisionMask& mask){
+        if(m_opacity > 0.f && m_mode == FOG){
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                mask.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(mask, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::draw(const ExploredMask& explored){
         if(m_opacity > 0.f && m_mode == FOG){
-            sf::RenderStates fogrs;
-            fogrs.blendMode = l_substractAlpha;
-            fogrs.transform *= Transformable::getTransform().getInverse();
-            m_renderTexture.draw(light, fogrs);
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                explored.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(explored, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::draw(const LightSet& set){
+        drawCulled(set, getGlobalBounds());
+    }
+    
+    void LightingArea::draw(const LightSet& set, const sf::View& view){
+        sf::FloatRect region;
+        if(getViewBounds(view).intersects(getGlobalBounds(), region)){
+            drawCulled(set, region);
+        }
+    }
+    
+    void LightingArea::draw(const OccluderGroup& group){
+        if(m_opacity > 0.f && m_mode == FOG){
+            sf::RenderStates fogrs = getFogStates();
+            if(m_backend == SOFTWARE){
+                group.rasterize(m_softwareTarget, fogrs);
+            }else{
+                m_renderTexture.draw(group, fogrs);
+            }
+        }
+    }
+    
+    void LightingArea::drawCulled(const LightSet& set, const sf::FloatRect& region){
+        if(m_opacity > 0.f && m_mode == FOG){
+            sf::RenderStates fogrs = getFogStates();
+            for(size_t i = 0; i < set.m_lights.size(); i++){
+                if(!set.m_bounds[i].intersects(region)){
+                    continue;
+                }
+                if(m_backend == SOFTWARE){
+                    set.m_lights[i]->rasterize(m_softwareTarget, fogrs);
+                }else{
+                    m_renderTexture.draw(*set.m_lights[i], fogrs);
+                }
+            }
         }
     }
     
+    Visibility LightingArea::cull(const LightSource& light) const{
+        return testVisibility(light, getGlobalBounds());
+    }
+    
+    Visibility LightingArea::cull(const LightSource& light, const sf::View& view) const{
+        sf::FloatRect region;
+        if(!getGlobalBounds().intersects(getViewBounds(view), region)){
+            return HIDDEN;
+        }
+        return testVisibility(light, region);
+    }
+    
     void LightingArea::setAreaTexture(const sf::Texture* texture, sf::IntRect rect){
         m_baseTexture = texture;
+        if(m_backend == SOFTWARE){
+            m_baseImage = texture != nullptr ? texture->copyToImage() : sf::Image();
+        }
         if(rect.width == 0 && rect.height == 0 && texture != nullptr){
             rect.width = texture->getSize().x;
             rect.height = texture->getSize().y;
@@ -122,11 +341,38 @@ namespace candle{
         setTextureRect(rect);
     }
     
+    void LightingArea::setAreaImage(const sf::Image& image, sf::IntRect rect){
+        if(m_backend != SOFTWARE){
+            return;
+        }
+        m_baseTexture = nullptr;
+        m_baseImage = image;
+        if(rect.width == 0 && rect.height == 0){
+            rect.width = image.getSize().x;
+            rect.height = image.getSize().y;
+        }
+        initializeRenderTexture(sf::Vector2f(rect.width, rect.height));
+        setTextureRect(rect);
+    }
+    
+    void LightingArea::setResolutionScale(float scale){
+        if(!(scale > 0.f)){ // also rejects NaN
+            return;
+        }
+        m_resolutionScale = std::min(scale, 1.f);
+        initializeRenderTexture(m_size);
+    }
+    
+    float LightingArea::getResolutionScale() const{
+        return m_resolutionScale;
+    }
+    
     const sf::Texture* LightingArea::getAreaTexture() const{
         return m_baseTexture;
     }
     
     void LightingArea::setTextureRect(const sf::IntRect& rect){
+        m_staticLayerOutdated = true;
         m_baseTextureQuad[0].texCoords = sf::Vector2f(rect.left, rect.top);
         m_baseTextureQuad[1].texCoords = sf::Vector2f(rect.left + rect.width, rect.top);
         m_baseTextureQuad[2].texCoords = sf::Vector2f(rect.left + rect.width, rect.top + rect.height);
@@ -139,6 +385,7 @@ namespace candle{
     
     void LightingArea::setMode(Mode mode){
         m_mode = mode;
+        m_staticLayerOutdated = true;
     }
     
     LightingArea::Mode LightingArea::getMode() const{
@@ -146,6 +393,17 @@ namespace candle{
     }
     
     void LightingArea::display(){
-        m_renderTexture.display();
+        if(m_backend == SOFTWARE){
+            m_softwareTextureOutdated = true;
+        }else{
+            m_renderTexture.display();
+        }
+    }
+    
+    sf::Image LightingArea::copyToImage() const{
+        if(m_backend == SOFTWARE){
+            return m_softwareTarget.copyToImage();
+        }
+        return m_renderTexture.getTexture().copyToImage();
     }
 }
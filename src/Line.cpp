@@ -2,6 +2,7 @@
 
 #include "Candle/geometry/Line.hpp"
 #include "Candle/geometry/Vector2.hpp"
+#include "Candle/geometry/Trigonometry.hpp"
 
 namespace sfu{
     Line::Line(const sf::Vector2f& p1, const sf::Vector2f& p2):
@@ -11,11 +12,9 @@ namespace sfu{
     Line::Line(const sf::Vector2f& p, float angle):
         m_origin(p)
         {
-            const auto PI2 = sfu::PI*2;
-            float ang = (float)fmod(angle*sfu::PI/180.f + sfu::PI , PI2);
-            if(ang < 0) ang += PI2;
-            ang -= sfu::PI;
-            m_direction = {std::cos(ang), std::sin(ang)};
+            float sin, cos;
+            sfu::sincos(angle, sin, cos);
+            m_direction = {cos, sin};
         }
 
     sf::FloatRect Line::getGlobalBounds() const{
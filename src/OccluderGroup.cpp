@@ -0,0 +1,126 @@
+#include "Candle/OccluderGroup.hpp"
+
+#include <algorithm>
+
+namespace candle{
+    namespace{
+        sfu::Line transformLine(const sf::Transform& trm, const sfu::Line& line){
+            return sfu::Line(trm.transformPoint(line.m_origin),
+                             trm.transformPoint(line.m_origin + line.m_direction));
+        }
+
+        bool sameEdges(const EdgeVector& a, const EdgeVector& b){
+            if(a.size() != b.size()){
+                return false;
+            }
+            for(size_t i = 0; i < a.size(); i++){
+                if(a[i].m_origin != b[i].m_origin || a[i].m_direction != b[i].m_direction){
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    void OccluderGroup::addEdge(const sfu::Line& edge){
+        m_edges.push_back(edge);
+        invalidate();
+    }
+
+    void OccluderGroup::clearEdges(){
+        m_edges.clear();
+        invalidate();
+    }
+
+    const EdgeVector& OccluderGroup::getEdges() const{
+        return m_edges;
+    }
+
+    void OccluderGroup::getGlobalEdges(EdgeVector& edges) const{
+        const sf::Transform& trm = getTransform();
+        for(auto& e: m_edges){
+            edges.push_back(transformLine(trm, e));
+        }
+    }
+
+    void OccluderGroup::attach(LightSource& light){
+        Attachment a;
+        a.light = &light;
+        std::fill(a.matrix, a.matrix + 16, 0.f);
+        a.range = 0.f;
+        a.dirty = true;
+        m_lights.push_back(a);
+    }
+
+    bool OccluderGroup::detach(const LightSource& light){
+        for(auto it = m_lights.begin(); it != m_lights.end(); it++){
+            if(it->light == &light){
+                m_lights.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t OccluderGroup::getLightCount() const{
+        return m_lights.size();
+    }
+
+    void OccluderGroup::invalidate(){
+        for(auto& a: m_lights){
+            a.dirty = true;
+        }
+    }
+
+    void OccluderGroup::invalidate(const LightSource& light){
+        for(auto& a: m_lights){
+            if(a.light == &light){
+                a.dirty = true;
+            }
+        }
+    }
+
+    unsigned int OccluderGroup::castLights(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        const sf::Transform& toGlobal = getTransform();
+        const sf::Transform& toLocal = getInverseTransform();
+        unsigned int casted = 0;
+        for(auto& a: m_lights){
+            LightSource& light = *a.light;
+            sf::FloatRect bounds = toGlobal.transformRect(light.getGlobalBounds());
+            m_seen.clear();
+            for(auto it = begin; it != end; it++){
+                if(bounds.intersects(it->getGlobalBounds())){
+                    m_seen.push_back(transformLine(toLocal, *it));
+                }
+            }
+            const float* matrix = light.getTransform().getMatrix();
+            bool moved = !std::equal(matrix, matrix + 16, a.matrix);
+            if(!a.dirty && !moved && a.range == light.getRange() && sameEdges(m_seen, a.seen)){
+                continue;
+            }
+            m_castEdges.assign(m_edges.begin(), m_edges.end());
+            m_castEdges.insert(m_castEdges.end(), m_seen.begin(), m_seen.end());
+            light.castLight(m_castEdges.begin(), m_castEdges.end());
+            a.seen.swap(m_seen);
+            std::copy(matrix, matrix + 16, a.matrix);
+            a.range = light.getRange();
+            a.dirty = false;
+            casted++;
+        }
+        return casted;
+    }
+
+    void OccluderGroup::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        st.transform *= getTransform();
+        for(auto& a: m_lights){
+            t.draw(*a.light, st);
+        }
+    }
+
+    void OccluderGroup::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        st.transform *= getTransform();
+        for(auto& a: m_lights){
+            a.light->rasterize(t, st);
+        }
+    }
+}
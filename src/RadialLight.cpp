@@ -3,6 +3,9 @@
 #endif
 
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <future>
 #include "Candle/RadialLight.hpp"
 
 #include "SFML/Graphics.hpp"
@@ -10,10 +13,13 @@
 #include "Candle/graphics/VertexArray.hpp"
 #include "Candle/geometry/Vector2.hpp"
 #include "Candle/geometry/Line.hpp"
+#include "Candle/geometry/BasicLine.hpp"
+#include "Candle/geometry/Trigonometry.hpp"
 
 namespace candle{
     int RadialLight::s_instanceCount = 0;
     const float BASE_RADIUS = 400.0f;
+    const size_t MIN_RAYS_PER_SECTOR = 256;
     bool l_texturesReady(false);
     std::unique_ptr<sf::RenderTexture> l_lightTextureFade;
     std::unique_ptr<sf::RenderTexture> l_lightTexturePlain;
@@ -51,6 +57,16 @@ namespace candle{
         l_lightTexturePlain->setSmooth(true);
     }
 
+    float l_textureFade(const sf::Vector2f& tc){
+        sf::Vector2f d(tc.x - BASE_RADIUS - 1, tc.y - BASE_RADIUS - 1);
+        return std::max(0.f, 1.f - sfu::magnitude(d) / BASE_RADIUS);
+    }
+
+    float l_texturePlain(const sf::Vector2f& tc){
+        sf::Vector2f d(tc.x - BASE_RADIUS - 1, tc.y - BASE_RADIUS - 1);
+        return sfu::magnitude2(d) <= BASE_RADIUS*BASE_RADIUS ? 1.f : 0.f;
+    }
+
     float module360(float x){
         x = (float)fmod(x,360.f);
         if(x < 0.f) x += 360.f;
@@ -59,12 +75,9 @@ namespace candle{
 
     RadialLight::RadialLight()
         : LightSource()
+        , m_sectors(1)
+        , m_exactCasting(false)
         {
-        if(!l_texturesReady){
-            // The first time we create a RadialLight, we must create the textures
-            initializeTextures();
-            l_texturesReady = true;
-        }
         m_polygon.setPrimitiveType(sf::TriangleFan);
         m_polygon.resize(6);
         m_polygon[0].position =
@@ -83,10 +96,12 @@ namespace candle{
         setRange(1.0f);
         setBeamAngle(360.f);
         // castLight();
+        allowAsyncCast(typeid(RadialLight));
         s_instanceCount++;
     }
 
     RadialLight::~RadialLight(){
+        waitForCast();
         s_instanceCount--;
         #ifdef RADIAL_LIGHT_FIX
         if (s_instanceCount == 0 &&
@@ -103,11 +118,33 @@ namespace candle{
         #endif
     }
 
-    void RadialLight::draw(sf::RenderTarget& t, sf::RenderStates s) const{
+    const sf::Texture* RadialLight::getLightTexture(bool fade){
+        if(!l_texturesReady){
+            // The first time we draw a RadialLight, we must create the textures
+            initializeTextures();
+            l_texturesReady = true;
+        }
+        return fade ? &l_lightTextureFade->getTexture() : &l_lightTexturePlain->getTexture();
+    }
+
+    sfu::SoftwareTarget::TextureFunction RadialLight::getLightTextureFunction(bool fade){
+        return fade ? l_textureFade : l_texturePlain;
+    }
+
+    sf::FloatRect RadialLight::getLightTextureRect(){
+        // Bounding square of the circle drawn in the textures
+        return sf::FloatRect(1.f, 1.f, BASE_RADIUS*2, BASE_RADIUS*2);
+    }
+
+    sf::Transform RadialLight::getPolygonTransform() const{
         sf::Transform trm = Transformable::getTransform();
         trm.scale(m_range/BASE_RADIUS, m_range/BASE_RADIUS, BASE_RADIUS, BASE_RADIUS);
-        s.transform *= trm;
-        s.texture = m_fade ? &l_lightTextureFade->getTexture() : &l_lightTexturePlain->getTexture();
+        return trm;
+    }
+
+    void RadialLight::draw(sf::RenderTarget& t, sf::RenderStates s) const{
+        s.transform *= getPolygonTransform();
+        s.texture = getLightTexture(m_fade);
         if(s.blendMode == sf::BlendAlpha){
             s.blendMode = sf::BlendAdd;
         }
@@ -118,6 +155,14 @@ namespace candle{
         t.draw(m_debug, deb_s);
 #endif
     }
+    void RadialLight::rasterize(sfu::SoftwareTarget& t, sf::RenderStates s) const{
+        s.transform *= getPolygonTransform();
+        if(s.blendMode == sf::BlendAlpha){
+            s.blendMode = sf::BlendAdd;
+        }
+        t.draw(m_polygon, s, getLightTextureFunction(m_fade));
+    }
+
     void RadialLight::resetColor(){
         sfu::setColor(m_polygon, m_color);
     }
@@ -128,132 +173,409 @@ namespace candle{
 
     float RadialLight::getBeamAngle() const{
         return m_beamAngle;
-    }
-
-    sf::FloatRect RadialLight::getLocalBounds() const{
-        return sf::FloatRect(0.0f, 0.0f, BASE_RADIUS*2, BASE_RADIUS*2);
-    }
-
-    sf::FloatRect RadialLight::getGlobalBounds() const{
-        float scaledRange = m_range / BASE_RADIUS;
-        sf::Transform trm = Transformable::getTransform();
-        trm.scale(scaledRange, scaledRange, BASE_RADIUS, BASE_RADIUS);
-        return trm.transformRect( getLocalBounds() );
     }
 
-    void RadialLight::castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+    void RadialLight::setSectorCount(unsigned int sectors){
+        m_sectors = std::max(1u, sectors);
+    }
+
+    unsigned int RadialLight::getSectorCount() const{
+        return m_sectors;
+    }
+
+    void RadialLight::setExactCasting(bool exact){
+        m_exactCasting = exact;
+    }
+
+    bool RadialLight::getExactCasting() const{
+        return m_exactCasting;
+    }
+
+    sf::FloatRect RadialLight::getLocalBounds() const{
+        return sf::FloatRect(0.0f, 0.0f, BASE_RADIUS*2, BASE_RADIUS*2);
+    }
+
+    sf::FloatRect RadialLight::getGlobalBounds() const{
+        float scaledRange = m_range / BASE_RADIUS;
+        sf::Transform trm = Transformable::getTransform();
+        trm.scale(scaledRange, scaledRange, BASE_RADIUS, BASE_RADIUS);
+        return trm.transformRect( getLocalBounds() );
+    }
+
+    float RadialLight::getIllumination(const sf::Vector2f& point) const{
+        size_t n = m_polygon.getVertexCount();
+        if(n < 3){
+            return 0.f;
+        }
+        // The polygon and the falloff are in the space of the light texture
+        sf::Vector2f p = getPolygonTransform().getInverse().transformPoint(point);
+        float falloff = m_fade ? l_textureFade(p) : l_texturePlain(p);
+        if(falloff <= 0.f){
+            return 0.f;
+        }
+        const sf::Vector2f c = m_polygon[0].position;
+        if(p == c){
+            return falloff * getIntensity();
+        }
+
+        // The vertices of the fan are sorted by angle, starting from the
+        // first one. If the fan is closed, the last vertex repeats it.
+        float a1 = sfu::angle(m_polygon[1].position - c);
+        auto rel = [&](size_t i){
+            return module360(sfu::angle(m_polygon[i].position - c) - a1);
+        };
+        size_t last = n - 1;
+        float aLast = m_polygon[last].position == m_polygon[1].position ? 360.f : rel(last);
+        float ap = module360(sfu::angle(p - c) - a1);
+        if(ap > aLast){
+            return 0.f;
+        }
+        size_t lo = 2, hi = last;
+        while(lo < hi){
+            size_t mid = (lo + hi) / 2;
+            if(rel(mid) < ap){
+                lo = mid + 1;
+            }else{
+                hi = mid;
+            }
+        }
+
+        // Inside the wedge, check the side of the edge of the triangle
+        const sf::Vector2f a = m_polygon[lo - 1].position;
+        const sf::Vector2f b = m_polygon[lo].position;
+        sf::Vector2f ab = b - a;
+        auto side = [&](const sf::Vector2f& q){
+            return ab.x * (q.y - a.y) - ab.y * (q.x - a.x);
+        };
+        if(side(p) * side(c) < 0.f){
+            return 0.f;
+        }
+        return falloff * getIntensity();
+    }
+
+    void RadialLight::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon){
+        CapsuleVector none;
+        castPolygon(begin, end, none.begin(), none.end(), polygon);
+    }
+
+    void RadialLight::castPolygon(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                  const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                                  sf::VertexArray& polygon){
+        if(m_exactCasting && m_beamAngle < 0.1f && capsulesBegin == capsulesEnd){
+            castExact(begin, end, polygon);
+            return;
+        }
+        castArc(begin,
+                end,
+                capsulesBegin,
+                capsulesEnd,
+                module360(getRotation() - m_beamAngle/2),
+                module360(getRotation() + m_beamAngle/2),
+                m_beamAngle < 0.1f,
+                polygon);
+    }
+
+    void RadialLight::castLight(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, const sf::FloatRect& clip){
+        auto castPoint = Transformable::getPosition();
+        if(clip.contains(castPoint)){
+            castLight(begin, end);
+            return;
+        }
+        if(!getGlobalBounds().intersects(clip)){
+            m_polygon.resize(0);
+            return;
+        }
+
+        // Angular interval subtended by the clip rectangle. As the cast point
+        // is outside, it is always smaller than 180 degrees.
+        sf::Vector2f corners[4] = {
+            {clip.left, clip.top},
+            {clip.left + clip.width, clip.top},
+            {clip.left + clip.width, clip.top + clip.height},
+            {clip.left, clip.top + clip.height}
+        };
+        float a0 = sfu::angle(corners[0] - castPoint);
+        float dmin = 0.f, dmax = 0.f;
+        for(int i = 1; i < 4; i++){
+            float d = module360(sfu::angle(corners[i] - castPoint) - a0 + 180.f) - 180.f;
+            dmin = std::min(dmin, d);
+            dmax = std::max(dmax, d);
+        }
+        float view1 = module360(a0 + dmin);
+        float viewAngle = dmax - dmin;
+        CapsuleVector none;
+
+        if(m_beamAngle < 0.1f){
+            castArc(begin, end, none.begin(), none.end(), view1, module360(view1 + viewAngle), false, m_polygon);
+            return;
+        }
+
+        // Intersect the view interval with the beam, relative to the start of
+        // the beam
+        float beam1 = module360(getRotation() - m_beamAngle/2);
+        float vs = module360(view1 - beam1);
+        float ve = vs + viewAngle;
+        bool first = vs < m_beamAngle;
+        bool second = ve > 360.f;
+        if(first && second){
+            // Two disjoint intervals: cast the whole beam
+            castLight(begin, end);
+        }else if(first){
+            castArc(begin, end, none.begin(), none.end(), view1, module360(beam1 + std::min(ve, m_beamAngle)), false, m_polygon);
+        }else if(second){
+            castArc(begin, end, none.begin(), none.end(), beam1, module360(beam1 + std::min(ve - 360.f, m_beamAngle)), false, m_polygon);
+        }else{
+            m_polygon.resize(0);
+        }
+    }
+
+    // Beam policies of the casting kernel. The configuration of the beam is
+    // resolved once per cast, so the loops over the edges and the sort of
+    // the rays don't branch on it.
+    struct BeamLimits{
+        float bl1, bl2;
+        BeamLimits(float l1, float l2): bl1(l1), bl2(l2) {}
+    };
+
+    struct FullCircleBeam: public BeamLimits{
+        static const bool FULL = true;
+        FullCircleBeam(float l1, float l2): BeamLimits(l1, l2) {}
+        bool contains(float) const{
+            return true;
+        }
+        bool less(float a1, float a2) const{
+            return a1 < a2;
+        }
+    };
+
+    struct ConeBeam: public BeamLimits{
+        static const bool FULL = false;
+        ConeBeam(float l1, float l2): BeamLimits(l1, l2) {}
+        bool contains(float a) const{
+            return a > bl1 && a < bl2;
+        }
+        bool less(float a1, float a2) const{
+            return a1 < a2;
+        }
+    };
+
+    // Cone that crosses the 0 degrees direction (bl1 > bl2)
+    struct WrappedConeBeam: public BeamLimits{
+        static const bool FULL = false;
+        float _bl1, _bl2;
+        WrappedConeBeam(float l1, float l2)
+            : BeamLimits(l1, l2)
+            , _bl1(l1-0.1)
+            , _bl2(l2+0.1)
+            {}
+        bool contains(float a) const{
+            return a > bl1 || a < bl2;
+        }
+        bool less(float a1, float a2) const{
+            return (a1 >= _bl1 && a2 <= _bl2) || (a1 < a2 && (_bl1 <= a1 || a2 <= _bl2));
+        }
+    };
+
+    // Integer coordinates are exact if the differences between them are
+    // below 32768 (see sfu::GeometryTraits)
+    bool isGridPoint(const sf::Vector2f& p){
+        return p.x == std::floor(p.x) && p.y == std::floor(p.y)
+            && std::abs(p.x) < 16384.f && std::abs(p.y) < 16384.f;
+    }
+
+    template <typename T>
+    void castVisibilityFan(const EdgeVector& edges, const sf::Vector2f& origin, float range, std::vector<sf::Vector2f>& points){
+        std::vector<sfu::BasicLine<T>> segments;
+        segments.reserve(edges.size());
+        for(auto& e: edges){
+            segments.emplace_back(sf::Vector2<T>(e.m_origin), sf::Vector2<T>(e.point(1.f)));
+        }
+        sfu::castVisibility(segments.cbegin(), segments.cend(), sf::Vector2<T>(origin), (T)std::ceil(range), points);
+    }
+
+    void RadialLight::castExact(const EdgeVector::iterator& begin, const EdgeVector::iterator& end, sf::VertexArray& polygon){
+        sf::Vector2f castPoint = Transformable::getPosition();
+        sf::FloatRect lightBounds = getGlobalBounds();
+        EdgeVector edges;
+        bool grid = isGridPoint(castPoint) && m_range < 16384.f;
+        for(auto it = begin; it != end; it++){
+            if(lightBounds.intersects(it->getGlobalBounds())){
+                edges.push_back(*it);
+                grid = grid && isGridPoint(it->m_origin) && isGridPoint(it->point(1.f));
+            }
+        }
+        std::vector<sf::Vector2f> points;
+        if(grid){
+            castVisibilityFan<int>(edges, castPoint, m_range, points);
+        }else{
+            castVisibilityFan<double>(edges, castPoint, m_range, points);
+        }
+
+        float scaledRange = m_range / BASE_RADIUS;
+        sf::Transform trm = Transformable::getTransform();
+        trm.scale(scaledRange, scaledRange, BASE_RADIUS, BASE_RADIUS);
+        sf::Transform tr_i = trm.getInverse();
+        polygon.resize(points.size() + 2); // + center and last
+        polygon[0].color = m_color;
+        polygon[0].position = polygon[0].texCoords = tr_i.transformPoint(castPoint);
+#ifdef CANDLE_DEBUG
+        sf::VertexArray& debug = getDebugLines(polygon);
+        debug.resize(points.size()*2);
+#endif
+        for(unsigned i=0; i < points.size(); i++){
+            sf::Vector2f p = tr_i.transformPoint(points[i]);
+            polygon[i+1].position = p;
+            polygon[i+1].texCoords = p;
+            polygon[i+1].color = m_color;
+#ifdef CANDLE_DEBUG
+            debug[i*2].position = polygon[0].position;
+            debug[i*2+1].position = p;
+            debug[i*2].color = debug[i*2+1].color = sf::Color::Magenta;
+#endif
+        }
+        polygon[points.size()+1] = polygon[1];
+    }
+
+    void RadialLight::castArc(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                              const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                              float bl1, float bl2, bool fullCircle, sf::VertexArray& polygon){
+        if(fullCircle){
+            castKernel(begin, end, capsulesBegin, capsulesEnd, FullCircleBeam(bl1, bl2), polygon);
+        }else if(bl1 > bl2){
+            castKernel(begin, end, capsulesBegin, capsulesEnd, WrappedConeBeam(bl1, bl2), polygon);
+        }else{
+            castKernel(begin, end, capsulesBegin, capsulesEnd, ConeBeam(bl1, bl2), polygon);
+        }
+    }
+
+    template <typename Beam>
+    void RadialLight::castKernel(const EdgeVector::iterator& begin, const EdgeVector::iterator& end,
+                                 const CapsuleVector::iterator& capsulesBegin, const CapsuleVector::iterator& capsulesEnd,
+                                 const Beam& beam, sf::VertexArray& polygon){
+
         float scaledRange = m_range / BASE_RADIUS;
         sf::Transform trm = Transformable::getTransform();
         trm.scale(scaledRange, scaledRange, BASE_RADIUS, BASE_RADIUS);
         std::vector<sfu::Line> rays;
 
-        rays.reserve(2 + std::distance(begin, end) * 2 * 3); // 2: beam angle, 4: corners, 2: pnts/sgmnt, 3 rays/pnt
+        rays.reserve(2 + std::distance(begin, end) * 2 * 3 // 2: beam angle, 4: corners, 2: pnts/sgmnt, 3 rays/pnt
+                     + std::distance(capsulesBegin, capsulesEnd) * 2 * 2); // 2: tangents/capsule, 2 rays/tangent
 
         // Start casting
-        float bl1 = module360(getRotation() - m_beamAngle/2);
-        float bl2 = module360(getRotation() + m_beamAngle/2);
-        bool beamAngleBigEnough = m_beamAngle < 0.1f;
         auto castPoint = Transformable::getPosition();
         float off = .001f;
-
-        auto angleInBeam = [&](float a)-> bool {
-            return beamAngleBigEnough
-                   ||(bl1 < bl2 && a > bl1 && a < bl2)
-                   ||(bl1 > bl2 && (a > bl1 || a < bl2));
-        };
+        // The rays next to each endpoint are rotated with a matrix instead
+        // of building them from their angle
+        float offSin, offCos;
+        sfu::sincos(off, offSin, offCos);
 
         for(float a = 45.f; a < 360.f; a += 90.f){
-            if(beamAngleBigEnough || angleInBeam(a)){
+            if(beam.contains(a)){
                 rays.emplace_back(castPoint, a);
             }
         }
-
+
         sf::FloatRect lightBounds = getGlobalBounds();
         for(auto it = begin; it != end; it++){
             auto& s = *it;
-
+
             //Only cast a ray if the line is in range
             if( lightBounds.intersects( s.getGlobalBounds() ) ){
                 sfu::Line r1(castPoint, s.m_origin);
                 sfu::Line r2(castPoint, s.point(1.f));
                 float a1 = sfu::angle(r1.m_direction);
                 float a2 = sfu::angle(r2.m_direction);
-                if(angleInBeam(a1)){
+                if(beam.contains(a1)){
                     rays.push_back(r1);
-                    rays.emplace_back(castPoint, a1 - off);
-                    rays.emplace_back(castPoint, a1 + off);
+                    rays.emplace_back(castPoint, castPoint + sfu::rotate(r1.m_direction, offCos, -offSin));
+                    rays.emplace_back(castPoint, castPoint + sfu::rotate(r1.m_direction, offCos, offSin));
                 }
-                if(angleInBeam(a2)){
+                if(beam.contains(a2)){
                     rays.push_back(r2);
-                    rays.emplace_back(castPoint, a2 - off);
-                    rays.emplace_back(castPoint, a2 + off);
+                    rays.emplace_back(castPoint, castPoint + sfu::rotate(r2.m_direction, offCos, -offSin));
+                    rays.emplace_back(castPoint, castPoint + sfu::rotate(r2.m_direction, offCos, offSin));
                 }
             }
         }
 
-        if(bl1 > bl2){
-            std::sort(
-                rays.begin(),
-                rays.end(),
-                [bl1, bl2] (sfu::Line& r1, sfu::Line& r2){
-                    float _bl1 = bl1-0.1;
-                    float _bl2 = bl2+0.1;
-                    float a1 = sfu::angle(r1.m_direction);
-                    float a2 = sfu::angle(r2.m_direction);
-                    return (a1 >= _bl1 && a2 <= _bl2) || (a1 < a2 && (_bl1 <= a1 || a2 <= _bl2));
-                }
-            );
-        }else{
-            std::sort(
-                rays.begin(),
-                rays.end(),
-                [bl1] (sfu::Line& r1, sfu::Line& r2){
-                    return
-                        sfu::angle(r1.m_direction) < sfu::angle(r2.m_direction);
+        for(auto it = capsulesBegin; it != capsulesEnd; it++){
+            sf::Vector2f t[2];
+            if(lightBounds.intersects(it->getGlobalBounds()) && it->tangents(castPoint, t[0], t[1])){
+                for(int i = 0; i < 2; i++){
+                    // A ray at each side of the silhouette, one hitting the
+                    // capsule and the other passing by
+                    sf::Vector2f d = t[i] - castPoint;
+                    if(beam.contains(sfu::angle(d))){
+                        rays.emplace_back(castPoint, castPoint + sfu::rotate(d, offCos, -offSin));
+                        rays.emplace_back(castPoint, castPoint + sfu::rotate(d, offCos, offSin));
+                    }
                 }
-            );
+            }
         }
-        if(!beamAngleBigEnough){
-            rays.emplace(rays.begin(), castPoint, bl1);
-            rays.emplace_back(castPoint, bl2);
+
+        std::sort(
+            rays.begin(),
+            rays.end(),
+            [&beam] (const sfu::Line& r1, const sfu::Line& r2){
+                return beam.less(sfu::angle(r1.m_direction), sfu::angle(r2.m_direction));
+            }
+        );
+        if(!Beam::FULL){
+            rays.emplace(rays.begin(), castPoint, beam.bl1);
+            rays.emplace_back(castPoint, beam.bl2);
         }
 
         sf::Transform tr_i = trm.getInverse();
         // keep only the ones within the area
-        std::vector<sf::Vector2f> points;
-        points.reserve(rays.size());
-        for (auto& r: rays){
-            points.push_back(tr_i.transformPoint(castRay(begin, end,    r, m_range*m_range)));
+        std::vector<sf::Vector2f> points(rays.size());
+        auto castSector = [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                points[i] = tr_i.transformPoint(sfu::castRay(begin, end, capsulesBegin, capsulesEnd, rays[i], m_range*m_range));
+            }
+        };
+        // Each sector is a contiguous range of the sorted rays, so the seams
+        // are shared vertices of the same fan. Small lights are not split, as
+        // the threads would cost more than the rays.
+        size_t sectors = std::min<size_t>(m_sectors, 1 + rays.size() / MIN_RAYS_PER_SECTOR);
+        size_t sectorSize = (rays.size() + sectors - 1) / sectors;
+        std::vector<std::future<void>> workers;
+        for(size_t first = sectorSize; first < rays.size(); first += sectorSize){
+            workers.push_back(std::async(std::launch::async, castSector, first, std::min(first + sectorSize, rays.size())));
+        }
+        castSector(0, std::min(sectorSize, rays.size()));
+        for(auto& w: workers){
+            w.get();
         }
-        m_polygon.resize(points.size() + 1 + beamAngleBigEnough); // + center and last
-        m_polygon[0].color = m_color;
-        m_polygon[0].position = m_polygon[0].texCoords = tr_i.transformPoint(castPoint);
+        polygon.resize(points.size() + 1 + Beam::FULL); // + center and last
+        polygon[0].color = m_color;
+        polygon[0].position = polygon[0].texCoords = tr_i.transformPoint(castPoint);
 #ifdef CANDLE_DEBUG
-        float bl1rad = bl1 * sfu::PI/180.f;
-        float bl2rad = bl2 * sfu::PI/180.f;
+        sf::VertexArray& debug = getDebugLines(polygon);
+        float bl1rad = beam.bl1 * sfu::PI/180.f;
+        float bl2rad = beam.bl2 * sfu::PI/180.f;
         sf::Vector2f al1(std::cos(bl1rad), std::sin(bl1rad));
         sf::Vector2f al2(std::cos(bl2rad), std::sin(bl2rad));
         int d_n = points.size()*2 + 4;
-        m_debug.resize(d_n);
-        m_debug[d_n-1].color = m_debug[d_n-2].color = sf::Color::Cyan;
-        m_debug[d_n-3].color = m_debug[d_n-4].color = sf::Color::Yellow;
-        m_debug[d_n-1].position = m_debug[d_n-3].position = m_polygon[0].position;
-        m_debug[d_n-2].position = tr_i.transformPoint(castPoint + m_range * al1);
-        m_debug[d_n-4].position = tr_i.transformPoint(castPoint + m_range * al2);
+        debug.resize(d_n);
+        debug[d_n-1].color = debug[d_n-2].color = sf::Color::Cyan;
+        debug[d_n-3].color = debug[d_n-4].color = sf::Color::Yellow;
+        debug[d_n-1].position = debug[d_n-3].position = polygon[0].position;
+        debug[d_n-2].position = tr_i.transformPoint(castPoint + m_range * al1);
+        debug[d_n-4].position = tr_i.transformPoint(castPoint + m_range * al2);
 #endif
         for(unsigned i=0; i < points.size(); i++){
             sf::Vector2f p = points[i];
-            m_polygon[i+1].position = p;
-            m_polygon[i+1].texCoords = p;
-            m_polygon[i+1].color = m_color;
+            polygon[i+1].position = p;
+            polygon[i+1].texCoords = p;
+            polygon[i+1].color = m_color;
 #ifdef CANDLE_DEBUG
-            m_debug[i*2].position = m_polygon[0].position;
-            m_debug[i*2+1].position = p;
-            m_debug[i*2].color = m_debug[i*2+1].color = sf::Color::Magenta;
+            debug[i*2].position = polygon[0].position;
+            debug[i*2+1].position = p;
+            debug[i*2].color = debug[i*2+1].color = sf::Color::Magenta;
 #endif
         }
-        if(beamAngleBigEnough){
-            m_polygon[points.size()+1] = m_polygon[1];
+        if(Beam::FULL){
+            polygon[points.size()+1] = polygon[1];
         }
     }
 
@@ -0,0 +1,281 @@
+#include "Candle/Raycast.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <thread>
+
+#include "Candle/geometry/Vector2.hpp"
+
+namespace candle{
+    namespace{
+        // Run f(i) for each i in [0, n), interleaving small chunks among the
+        // threads, as computeVisibility
+        template <typename F>
+        void parallelFor(size_t n, unsigned int threads, const F& f){
+            if(threads == 0){
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            threads = std::min<size_t>(threads, n);
+            if(threads <= 1){
+                for(size_t i = 0; i < n; i++){
+                    f(i);
+                }
+                return;
+            }
+            size_t chunk = std::max<size_t>(1, n / (threads * 8));
+            std::vector<std::future<void>> workers;
+            for(unsigned int t = 0; t < threads; t++){
+                workers.push_back(std::async(std::launch::async, [&, t](){
+                    for(size_t first = t * chunk; first < n; first += threads * chunk){
+                        size_t last = std::min(first + chunk, n);
+                        for(size_t i = first; i < last; i++){
+                            f(i);
+                        }
+                    }
+                }));
+            }
+            for(auto& w: workers){
+                w.get();
+            }
+        }
+    }
+
+    EdgeGrid::EdgeGrid()
+        : m_cellSize(1.f)
+        , m_cols(0)
+        , m_rows(0)
+        , m_edgeCount(0)
+        {}
+
+    EdgeGrid::EdgeGrid(const std::vector<sfu::Line>& edges, float cellSize)
+        : EdgeGrid()
+        {
+            build(edges, cellSize);
+        }
+
+    void EdgeGrid::build(const std::vector<sfu::Line>& edges, float cellSize){
+        m_cellStart.clear();
+        m_ox.clear();
+        m_oy.clear();
+        m_dx.clear();
+        m_dy.clear();
+        m_index.clear();
+        m_edgeCount = edges.size();
+        m_cols = m_rows = 0;
+        if(edges.empty()){
+            return;
+        }
+
+        sf::Vector2f max;
+        m_min = max = edges[0].m_origin;
+        for(auto& e: edges){
+            sf::Vector2f p2 = e.point(1.f);
+            m_min.x = std::min({m_min.x, e.m_origin.x, p2.x});
+            m_min.y = std::min({m_min.y, e.m_origin.y, p2.y});
+            max.x = std::max({max.x, e.m_origin.x, p2.x});
+            max.y = std::max({max.y, e.m_origin.y, p2.y});
+        }
+        float side = std::max(max.x - m_min.x, max.y - m_min.y);
+        m_cellSize = std::max(cellSize, side / (MAX_CELLS - 1));
+        if(m_cellSize <= 0.f){
+            m_cellSize = 1.f;
+        }
+        m_cols = (int)((max.x - m_min.x) / m_cellSize) + 1;
+        m_rows = (int)((max.y - m_min.y) / m_cellSize) + 1;
+
+        // Cells touched by each edge: the ones of its bounding box that have
+        // corners at both sides of it (or on it)
+        std::vector<std::pair<unsigned int, unsigned int>> entries;
+        auto cellOf = [&](float v, float min, int count){
+            return std::min(count - 1, std::max(0, (int)((v - min) / m_cellSize)));
+        };
+        for(unsigned int i = 0; i < edges.size(); i++){
+            const sfu::Line& e = edges[i];
+            sf::Vector2f p2 = e.point(1.f);
+            int c0 = cellOf(std::min(e.m_origin.x, p2.x), m_min.x, m_cols);
+            int c1 = cellOf(std::max(e.m_origin.x, p2.x), m_min.x, m_cols);
+            int r0 = cellOf(std::min(e.m_origin.y, p2.y), m_min.y, m_rows);
+            int r1 = cellOf(std::max(e.m_origin.y, p2.y), m_min.y, m_rows);
+            for(int r = r0; r <= r1; r++){
+                for(int c = c0; c <= c1; c++){
+                    if(c0 != c1 && r0 != r1){
+                        float x0 = m_min.x + c * m_cellSize - e.m_origin.x;
+                        float y0 = m_min.y + r * m_cellSize - e.m_origin.y;
+                        float x1 = x0 + m_cellSize, y1 = y0 + m_cellSize;
+                        auto side = [&](float x, float y){
+                            return e.m_direction.x * y - e.m_direction.y * x;
+                        };
+                        float s[4] = {side(x0, y0), side(x1, y0), side(x0, y1), side(x1, y1)};
+                        if(std::min({s[0], s[1], s[2], s[3]}) > 0.f ||
+                           std::max({s[0], s[1], s[2], s[3]}) < 0.f){
+                            continue;
+                        }
+                    }
+                    entries.emplace_back(r * m_cols + c, i);
+                }
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+
+        m_cellStart.assign(m_cols * m_rows + 1, 0);
+        m_ox.reserve(entries.size());
+        m_oy.reserve(entries.size());
+        m_dx.reserve(entries.size());
+        m_dy.reserve(entries.size());
+        m_index.reserve(entries.size());
+        for(auto& entry: entries){
+            const sfu::Line& e = edges[entry.second];
+            m_cellStart[entry.first + 1]++;
+            m_ox.push_back(e.m_origin.x);
+            m_oy.push_back(e.m_origin.y);
+            m_dx.push_back(e.m_direction.x);
+            m_dy.push_back(e.m_direction.y);
+            m_index.push_back(entry.second);
+        }
+        for(size_t c = 1; c < m_cellStart.size(); c++){
+            m_cellStart[c] += m_cellStart[c - 1];
+        }
+    }
+
+    size_t EdgeGrid::getEdgeCount() const{
+        return m_edgeCount;
+    }
+
+    template <bool AnyHit>
+    bool EdgeGrid::traverse(const sf::Vector2f& origin,
+                            const sf::Vector2f& direction,
+                            float& t,
+                            unsigned int& entry) const{
+        if(m_cols == 0 || (direction.x == 0.f && direction.y == 0.f)){
+            return false;
+        }
+        const float inf = std::numeric_limits<float>::infinity();
+
+        // Clip the ray to the grid
+        float t0 = 0.f, t1 = 1.f;
+        const float lo[2] = {m_min.x, m_min.y};
+        const float hi[2] = {m_min.x + m_cols * m_cellSize, m_min.y + m_rows * m_cellSize};
+        const float o[2] = {origin.x, origin.y};
+        const float d[2] = {direction.x, direction.y};
+        for(int a = 0; a < 2; a++){
+            if(d[a] == 0.f){
+                if(o[a] < lo[a] || o[a] > hi[a]){
+                    return false;
+                }
+            }else{
+                float ta = (lo[a] - o[a]) / d[a];
+                float tb = (hi[a] - o[a]) / d[a];
+                if(ta > tb){
+                    std::swap(ta, tb);
+                }
+                t0 = std::max(t0, ta);
+                t1 = std::min(t1, tb);
+            }
+        }
+        if(t0 > t1){
+            return false;
+        }
+
+        // Walk the cells in order (Amanatides & Woo)
+        int cell[2], step[2], count[2] = {m_cols, m_rows};
+        float tMax[2], tDelta[2];
+        for(int a = 0; a < 2; a++){
+            float p = o[a] + d[a] * t0;
+            cell[a] = std::min(count[a] - 1, std::max(0, (int)((p - lo[a]) / m_cellSize)));
+            step[a] = (d[a] > 0.f) - (d[a] < 0.f);
+            if(step[a] == 0){
+                tMax[a] = tDelta[a] = inf;
+            }else{
+                float boundary = lo[a] + (cell[a] + (step[a] > 0)) * m_cellSize;
+                tMax[a] = (boundary - o[a]) / d[a];
+                tDelta[a] = m_cellSize / std::abs(d[a]);
+            }
+        }
+
+        bool found = false;
+        t = inf;
+        while(true){
+            unsigned int c = cell[1] * m_cols + cell[0];
+            for(unsigned int k = m_cellStart[c]; k < m_cellStart[c + 1]; k++){
+                float ax = m_ox[k] - o[0];
+                float ay = m_oy[k] - o[1];
+                float den = d[0] * m_dy[k] - d[1] * m_dx[k];
+                if(den == 0.f){
+                    continue;
+                }
+                float tk = (ax * m_dy[k] - ay * m_dx[k]) / den;
+                float uk = (ax * d[1] - ay * d[0]) / den;
+                if(tk >= 0.f && tk <= 1.f && uk >= 0.f && uk <= 1.f && tk < t){
+                    t = tk;
+                    entry = k;
+                    found = true;
+                    if(AnyHit){
+                        return true;
+                    }
+                }
+            }
+            // A hit beyond this cell may be hidden by an edge of the next
+            // ones, so it is only accepted if it is inside
+            float tExit = std::min({tMax[0], tMax[1], t1});
+            if(found && t <= tExit){
+                return true;
+            }
+            if(tExit >= t1){
+                break;
+            }
+            int a = tMax[0] < tMax[1] ? 0 : 1;
+            cell[a] += step[a];
+            if(cell[a] < 0 || cell[a] >= count[a]){
+                break;
+            }
+            tMax[a] += tDelta[a];
+        }
+        return found;
+    }
+
+    RayHit EdgeGrid::castRay(const sfu::Line& ray) const{
+        RayHit hit;
+        float t;
+        unsigned int k;
+        hit.hit = traverse<false>(ray.m_origin, ray.m_direction, t, k);
+        if(hit.hit){
+            hit.edge = m_index[k];
+            hit.distance = t * sfu::magnitude(ray.m_direction);
+            hit.normal = sfu::normalize(sf::Vector2f(-m_dy[k], m_dx[k]));
+            if(sfu::dot(hit.normal, ray.m_direction) > 0.f){
+                hit.normal = -hit.normal;
+            }
+        }else{
+            hit.edge = 0;
+            hit.distance = sfu::magnitude(ray.m_direction);
+            hit.normal = sf::Vector2f(0.f, 0.f);
+        }
+        return hit;
+    }
+
+    bool EdgeGrid::lineOfSight(const sf::Vector2f& p1, const sf::Vector2f& p2) const{
+        float t;
+        unsigned int k;
+        return !traverse<true>(p1, p2 - p1, t, k);
+    }
+
+    void EdgeGrid::castRays(const std::vector<sfu::Line>& rays,
+                            std::vector<RayHit>& hits,
+                            unsigned int threads) const{
+        hits.resize(rays.size());
+        parallelFor(rays.size(), threads, [&](size_t i){
+            hits[i] = castRay(rays[i]);
+        });
+    }
+
+    void EdgeGrid::lineOfSight(const std::vector<sfu::Line>& segments,
+                               std::vector<char>& visible,
+                               unsigned int threads) const{
+        visible.resize(segments.size());
+        parallelFor(segments.size(), threads, [&](size_t i){
+            visible[i] = lineOfSight(segments[i].m_origin, segments[i].point(1.f));
+        });
+    }
+}
@@ -0,0 +1,31 @@
+/*
+ * Internal helpers to read and write the little endian integers of the
+ * binary formats (light maps and explored masks). Not installed.
+ */
+#ifndef __CANDLE_SERIALIZATION_HPP__
+#define __CANDLE_SERIALIZATION_HPP__
+
+#include <istream>
+#include <ostream>
+
+#include <SFML/Config.hpp>
+
+namespace candle{
+    inline void l_write(std::ostream& os, sf::Uint32 x, int bytes){
+        for(int i = 0; i < bytes; i++){
+            os.put((char)((x >> (8*i)) & 0xFF));
+        }
+    }
+
+    inline bool l_read(std::istream& is, sf::Uint32& x, int bytes){
+        x = 0;
+        for(int i = 0; i < bytes; i++){
+            int c = is.get();
+            if(c == EOF) return false;
+            x |= (sf::Uint32)(c & 0xFF) << (8*i);
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,393 @@
+#include "Candle/graphics/SoftwareTarget.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CANDLE_SOFTWARE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace sfu{
+    namespace{
+        /*
+         * A pixel is handled as a single RGBA vector, so every arithmetic
+         * operation of the blending is one SIMD instruction per pixel.
+         */
+#ifdef CANDLE_SOFTWARE_SSE
+        typedef __m128 Pixel;
+        inline Pixel p_load(const float* p){ return _mm_loadu_ps(p); }
+        inline void p_store(float* p, const Pixel& a){ _mm_storeu_ps(p, a); }
+        inline Pixel p_set(float r, float g, float b, float a){ return _mm_setr_ps(r, g, b, a); }
+        inline Pixel p_splat(float f){ return _mm_set1_ps(f); }
+        inline Pixel p_add(const Pixel& a, const Pixel& b){ return _mm_add_ps(a, b); }
+        inline Pixel p_sub(const Pixel& a, const Pixel& b){ return _mm_sub_ps(a, b); }
+        inline Pixel p_mul(const Pixel& a, const Pixel& b){ return _mm_mul_ps(a, b); }
+        inline Pixel p_alpha(const Pixel& a){ return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)); }
+        inline Pixel p_clamp(const Pixel& a){
+            return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        }
+        // rgb channels from a, alpha channel from b
+        inline Pixel p_merge(const Pixel& a, const Pixel& b){
+            const Pixel mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+#else
+        struct Pixel{ float v[4]; };
+        inline Pixel p_load(const float* p){ Pixel r = {{p[0], p[1], p[2], p[3]}}; return r; }
+        inline void p_store(float* p, const Pixel& a){ std::copy(a.v, a.v + 4, p); }
+        inline Pixel p_set(float r, float g, float b, float a){ Pixel p = {{r, g, b, a}}; return p; }
+        inline Pixel p_splat(float f){ return p_set(f, f, f, f); }
+        inline Pixel p_add(const Pixel& a, const Pixel& b){
+            return p_set(a.v[0]+b.v[0], a.v[1]+b.v[1], a.v[2]+b.v[2], a.v[3]+b.v[3]);
+        }
+        inline Pixel p_sub(const Pixel& a, const Pixel& b){
+            return p_set(a.v[0]-b.v[0], a.v[1]-b.v[1], a.v[2]-b.v[2], a.v[3]-b.v[3]);
+        }
+        inline Pixel p_mul(const Pixel& a, const Pixel& b){
+            return p_set(a.v[0]*b.v[0], a.v[1]*b.v[1], a.v[2]*b.v[2], a.v[3]*b.v[3]);
+        }
+        inline Pixel p_alpha(const Pixel& a){ return p_splat(a.v[3]); }
+        inline Pixel p_clamp(const Pixel& a){
+            Pixel r;
+            for(int i = 0; i < 4; i++) r.v[i] = std::min(1.f, std::max(0.f, a.v[i]));
+            return r;
+        }
+        inline Pixel p_merge(const Pixel& a, const Pixel& b){
+            return p_set(a.v[0], a.v[1], a.v[2], b.v[3]);
+        }
+#endif
+        inline Pixel p_color(const sf::Color& c){
+            return p_mul(p_set(c.r, c.g, c.b, c.a), p_splat(1.f/255.f));
+        }
+
+        inline Pixel factor(sf::BlendMode::Factor f, const Pixel& src, const Pixel& dst){
+            const Pixel one = p_splat(1.f);
+            switch(f){
+                case sf::BlendMode::Zero:             return p_splat(0.f);
+                case sf::BlendMode::One:              return one;
+                case sf::BlendMode::SrcColor:         return src;
+                case sf::BlendMode::OneMinusSrcColor: return p_sub(one, src);
+                case sf::BlendMode::DstColor:         return dst;
+                case sf::BlendMode::OneMinusDstColor: return p_sub(one, dst);
+                case sf::BlendMode::SrcAlpha:         return p_alpha(src);
+                case sf::BlendMode::OneMinusSrcAlpha: return p_sub(one, p_alpha(src));
+                case sf::BlendMode::DstAlpha:         return p_alpha(dst);
+                case sf::BlendMode::OneMinusDstAlpha: return p_sub(one, p_alpha(dst));
+            }
+            return one;
+        }
+
+        inline Pixel equation(sf::BlendMode::Equation e, const Pixel& s, const Pixel& d){
+            switch(e){
+                case sf::BlendMode::Subtract:        return p_sub(s, d);
+                case sf::BlendMode::ReverseSubtract: return p_sub(d, s);
+                default:                             return p_add(s, d);
+            }
+        }
+
+        inline Pixel blend(const sf::BlendMode& m, const Pixel& src, const Pixel& dst){
+            Pixel color = equation(m.colorEquation,
+                                   p_mul(src, factor(m.colorSrcFactor, src, dst)),
+                                   p_mul(dst, factor(m.colorDstFactor, src, dst)));
+            if(m.colorSrcFactor == m.alphaSrcFactor
+               && m.colorDstFactor == m.alphaDstFactor
+               && m.colorEquation == m.alphaEquation){
+                return p_clamp(color);
+            }
+            Pixel alpha = equation(m.alphaEquation,
+                                   p_mul(src, factor(m.alphaSrcFactor, src, dst)),
+                                   p_mul(dst, factor(m.alphaDstFactor, src, dst)));
+            return p_clamp(p_merge(color, alpha));
+        }
+
+        /*
+         * Blenders. The blend mode is resolved once per draw, so the span
+         * loops don't switch on the factors and equations for every pixel.
+         * The modes used by the library have their own blender, and any
+         * other mode goes through the generic one.
+         */
+        struct AddBlender{ // sf::BlendAdd
+            Pixel apply(const Pixel& src, const Pixel& dst) const{
+                Pixel color = p_add(p_mul(src, p_alpha(src)), dst);
+                return p_clamp(p_merge(color, p_add(src, dst)));
+            }
+        };
+
+        struct AlphaBlender{ // sf::BlendAlpha
+            Pixel apply(const Pixel& src, const Pixel& dst) const{
+                Pixel sa = p_alpha(src);
+                Pixel dstScaled = p_mul(dst, p_sub(p_splat(1.f), sa));
+                Pixel color = p_add(p_mul(src, sa), dstScaled);
+                return p_clamp(p_merge(color, p_add(src, dstScaled)));
+            }
+        };
+
+        struct FogBlender{ // keeps the color and multiplies dst.a by 1 - src.a
+            Pixel apply(const Pixel& src, const Pixel& dst) const{
+                const Pixel one = p_splat(1.f);
+                return p_clamp(p_mul(dst, p_merge(one, p_sub(one, p_alpha(src)))));
+            }
+        };
+
+        struct GenericBlender{
+            sf::BlendMode mode;
+            Pixel apply(const Pixel& src, const Pixel& dst) const{
+                return blend(mode, src, dst);
+            }
+        };
+
+        bool isFogBlend(const sf::BlendMode& m){
+            return m.colorSrcFactor == sf::BlendMode::Zero
+                && m.colorDstFactor == sf::BlendMode::One
+                && m.colorEquation == sf::BlendMode::Add
+                && m.alphaSrcFactor == sf::BlendMode::Zero
+                && m.alphaDstFactor == sf::BlendMode::OneMinusSrcAlpha
+                && m.alphaEquation == sf::BlendMode::Add;
+        }
+
+        struct PlainSampler{
+            static const bool textured = false;
+            Pixel apply(const Pixel& color, float, float) const{
+                return color;
+            }
+        };
+
+        struct FunctionSampler{
+            static const bool textured = true;
+            SoftwareTarget::TextureFunction function;
+            Pixel apply(const Pixel& color, float u, float v) const{
+                return p_mul(color, p_splat(function(sf::Vector2f(u, v))));
+            }
+        };
+
+        struct ImageSampler{
+            static const bool textured = true;
+            const sf::Image* image;
+            Pixel apply(const Pixel& color, float u, float v) const{
+                sf::Vector2u size = image->getSize();
+                int x = std::min(std::max(0, (int)std::floor(u)), (int)size.x - 1);
+                int y = std::min(std::max(0, (int)std::floor(v)), (int)size.y - 1);
+                return p_mul(color, p_color(image->getPixel(x, y)));
+            }
+        };
+
+        // Coefficients of an attribute interpolated linearly over a triangle
+        struct Plane{
+            float dx, dy, c;
+            Plane(const sf::Vector2f* p, float a0, float a1, float a2, float area){
+                dx = ((a1-a0) * (p[2].y-p[0].y) - (a2-a0) * (p[1].y-p[0].y)) / area;
+                dy = ((a2-a0) * (p[1].x-p[0].x) - (a1-a0) * (p[2].x-p[0].x)) / area;
+                c = a0 - dx*p[0].x - dy*p[0].y;
+            }
+            float at(float x, float y) const{
+                return dx*x + dy*y + c;
+            }
+        };
+    }
+
+    SoftwareTarget::SoftwareTarget()
+        : m_width(0)
+        , m_height(0)
+        {}
+
+    void SoftwareTarget::create(unsigned int width, unsigned int height){
+        m_width = width;
+        m_height = height;
+        m_pixels.assign(width * height * 4, 0.f);
+    }
+
+    sf::Vector2u SoftwareTarget::getSize() const{
+        return sf::Vector2u(m_width, m_height);
+    }
+
+    void SoftwareTarget::clear(const sf::Color& color){
+        Pixel c = p_color(color);
+        for(size_t i = 0; i < m_pixels.size(); i += 4){
+            p_store(&m_pixels[i], c);
+        }
+    }
+
+    void SoftwareTarget::draw(const sf::VertexArray& va, const sf::RenderStates& st, TextureFunction texture){
+        if(texture == nullptr){
+            drawPrimitives(va, st, PlainSampler());
+        }else{
+            FunctionSampler sampler;
+            sampler.function = texture;
+            drawPrimitives(va, st, sampler);
+        }
+    }
+
+    void SoftwareTarget::draw(const sf::VertexArray& va, const sf::RenderStates& st, const sf::Image& texture){
+        if(texture.getSize().x == 0 || texture.getSize().y == 0){
+            return;
+        }
+        ImageSampler sampler;
+        sampler.image = &texture;
+        drawPrimitives(va, st, sampler);
+    }
+
+    template <typename Sampler>
+    void SoftwareTarget::drawPrimitives(const sf::VertexArray& va, const sf::RenderStates& st, const Sampler& sampler){
+        const sf::BlendMode& mode = st.blendMode;
+        if(mode == sf::BlendAdd){
+            drawPrimitives(va, st.transform, sampler, AddBlender());
+        }else if(mode == sf::BlendAlpha){
+            drawPrimitives(va, st.transform, sampler, AlphaBlender());
+        }else if(isFogBlend(mode)){
+            drawPrimitives(va, st.transform, sampler, FogBlender());
+        }else{
+            GenericBlender blender;
+            blender.mode = mode;
+            drawPrimitives(va, st.transform, sampler, blender);
+        }
+    }
+
+    template <typename Sampler, typename Blender>
+    void SoftwareTarget::drawPrimitives(const sf::VertexArray& va, const sf::Transform& transform, const Sampler& sampler, const Blender& blender){
+        size_t n = va.getVertexCount();
+        sf::Vertex v[3];
+        auto tr = [&](size_t i) -> sf::Vertex {
+            sf::Vertex r = va[i];
+            r.position = transform.transformPoint(r.position);
+            return r;
+        };
+        switch(va.getPrimitiveType()){
+            case sf::Triangles:
+                for(size_t i = 0; i + 2 < n; i += 3){
+                    drawTriangle(tr(i), tr(i+1), tr(i+2), sampler, blender);
+                }
+                break;
+            case sf::TriangleStrip:
+                for(size_t i = 0; i + 2 < n; i++){
+                    drawTriangle(tr(i), tr(i+1), tr(i+2), sampler, blender);
+                }
+                break;
+            case sf::TriangleFan:
+                if(n >= 3){
+                    v[0] = tr(0);
+                    v[2] = tr(1);
+                    for(size_t i = 2; i < n; i++){
+                        v[1] = v[2];
+                        v[2] = tr(i);
+                        drawTriangle(v[0], v[1], v[2], sampler, blender);
+                    }
+                }
+                break;
+            case sf::Quads:
+                for(size_t i = 0; i + 3 < n; i += 4){
+                    v[0] = tr(i);
+                    v[1] = tr(i+2);
+                    drawTriangle(v[0], tr(i+1), v[1], sampler, blender);
+                    drawTriangle(v[0], v[1], tr(i+3), sampler, blender);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    template <typename Sampler, typename Blender>
+    void SoftwareTarget::drawTriangle(const sf::Vertex& v0,
+                                      const sf::Vertex& v1,
+                                      const sf::Vertex& v2,
+                                      const Sampler& sampler,
+                                      const Blender& blender){
+        const sf::Vector2f p[3] = {v0.position, v1.position, v2.position};
+        float area = (p[1].x-p[0].x) * (p[2].y-p[0].y) - (p[2].x-p[0].x) * (p[1].y-p[0].y);
+        if(std::abs(area) < 1e-6f || m_width == 0 || m_height == 0){
+            return;
+        }
+        float orientation = area > 0.f ? 1.f : -1.f;
+
+        Plane r(p, v0.color.r, v1.color.r, v2.color.r, area);
+        Plane g(p, v0.color.g, v1.color.g, v2.color.g, area);
+        Plane b(p, v0.color.b, v1.color.b, v2.color.b, area);
+        Plane a(p, v0.color.a, v1.color.a, v2.color.a, area);
+        Plane u(p, v0.texCoords.x, v1.texCoords.x, v2.texCoords.x, area);
+        Plane v(p, v0.texCoords.y, v1.texCoords.y, v2.texCoords.y, area);
+        const Pixel norm = p_splat(1.f/255.f);
+        const Pixel dc = p_mul(p_set(r.dx, g.dx, b.dx, a.dx), norm);
+
+        float minY = std::min(p[0].y, std::min(p[1].y, p[2].y));
+        float maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+        int y0 = std::max(0, (int)std::ceil(minY - 0.5f));
+        int y1 = std::min((int)m_height, (int)std::ceil(maxY - 0.5f));
+
+        for(int y = y0; y < y1; y++){
+            float yc = y + 0.5f;
+            // Each edge restricts the span to one side of it
+            float xl = -std::numeric_limits<float>::infinity();
+            float xr = std::numeric_limits<float>::infinity();
+            bool empty = false;
+            for(int e = 0; e < 3 && !empty; e++){
+                const sf::Vector2f& pi = p[e];
+                const sf::Vector2f& pj = p[(e+1) % 3];
+                float A = -orientation * (pj.y - pi.y);
+                if(A == 0.f){
+                    empty = orientation * (pj.x - pi.x) * (yc - pi.y) < 0.f;
+                    continue;
+                }
+                // The crossing is computed from the lowest end, so the
+                // triangles that share an edge leave neither gaps nor
+                // overlaps along it
+                const sf::Vector2f& lo = pi.y < pj.y ? pi : pj;
+                const sf::Vector2f& hi = pi.y < pj.y ? pj : pi;
+                float x = lo.x + (hi.x - lo.x) * (yc - lo.y) / (hi.y - lo.y);
+                if(A > 0.f){
+                    xl = std::max(xl, x);
+                }else{
+                    xr = std::min(xr, x);
+                }
+            }
+            if(empty){
+                continue;
+            }
+            int x0 = std::max(0, (int)std::ceil(xl - 0.5f));
+            int x1 = std::min((int)m_width, (int)std::ceil(xr - 0.5f));
+            if(x0 >= x1){
+                continue;
+            }
+
+            float xc = x0 + 0.5f;
+            Pixel c = p_mul(p_set(r.at(xc, yc), g.at(xc, yc), b.at(xc, yc), a.at(xc, yc)), norm);
+            float tu = 0.f, tv = 0.f;
+            if(Sampler::textured){
+                tu = u.at(xc, yc);
+                tv = v.at(xc, yc);
+            }
+            float* px = &m_pixels[(y * m_width + x0) * 4];
+            for(int x = x0; x < x1; x++){
+                p_store(px, blender.apply(sampler.apply(p_clamp(c), tu, tv), p_load(px)));
+                c = p_add(c, dc);
+                tu += u.dx;
+                tv += v.dx;
+                px += 4;
+            }
+        }
+    }
+
+    sf::Color SoftwareTarget::getPixel(unsigned int x, unsigned int y) const{
+        const float* p = &m_pixels[(y * m_width + x) * 4];
+        return sf::Color(
+            std::lround(p[0] * 255.f),
+            std::lround(p[1] * 255.f),
+            std::lround(p[2] * 255.f),
+            std::lround(p[3] * 255.f));
+    }
+
+    const float* SoftwareTarget::getPixelsPtr() const{
+        return m_pixels.empty() ? nullptr : &m_pixels[0];
+    }
+
+    sf::Image SoftwareTarget::copyToImage() const{
+        sf::Image image;
+        std::vector<sf::Uint8> bytes(m_pixels.size());
+        for(size_t i = 0; i < m_pixels.size(); i++){
+            bytes[i] = std::lround(m_pixels[i] * 255.f);
+        }
+        image.create(m_width, m_height, bytes.empty() ? nullptr : &bytes[0]);
+        return image;
+    }
+}
@@ -0,0 +1,216 @@
+#include "Candle/TiledLightingArea.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Candle/Culling.hpp"
+
+namespace candle{
+    TiledLightingArea::TiledLightingArea(LightingArea::Mode mode,
+                                         const sf::Vector2f& position,
+                                         const sf::Vector2f& size,
+                                         unsigned int tileSize,
+                                         LightingArea::Backend backend)
+        : m_mode(mode)
+        , m_backend(backend)
+        , m_bounds(position, size)
+        , m_tileSize(std::max(1u, tileSize))
+        , m_color(sf::Color::White)
+        , m_opacity(1.f)
+        {
+        m_columns = std::ceil(size.x / m_tileSize);
+        m_rows = std::ceil(size.y / m_tileSize);
+    }
+
+    sf::FloatRect TiledLightingArea::getGlobalBounds() const{
+        return m_bounds;
+    }
+
+    unsigned int TiledLightingArea::getTileSize() const{
+        return m_tileSize;
+    }
+
+    size_t TiledLightingArea::getAllocatedTileCount() const{
+        return m_tiles.size();
+    }
+
+    size_t TiledLightingArea::getDirtyTileCount() const{
+        return m_dirtyTiles.size();
+    }
+
+    sf::FloatRect TiledLightingArea::getTileBounds(int tile) const{
+        float left = m_bounds.left + (tile % m_columns) * (float)m_tileSize;
+        float top = m_bounds.top + (tile / m_columns) * (float)m_tileSize;
+        return sf::FloatRect(
+            left,
+            top,
+            std::min((float)m_tileSize, m_bounds.left + m_bounds.width - left),
+            std::min((float)m_tileSize, m_bounds.top + m_bounds.height - top));
+    }
+
+    void TiledLightingArea::markDirty(const sf::FloatRect& region){
+        sf::FloatRect r;
+        if(!m_bounds.intersects(region, r)){
+            return;
+        }
+        int i0 = std::max(0, (int)((r.left - m_bounds.left) / m_tileSize));
+        int j0 = std::max(0, (int)((r.top - m_bounds.top) / m_tileSize));
+        int i1 = std::min(m_columns - 1, (int)((r.left + r.width - m_bounds.left) / m_tileSize));
+        int j1 = std::min(m_rows - 1, (int)((r.top + r.height - m_bounds.top) / m_tileSize));
+        for(int j = j0; j <= j1; j++){
+            for(int i = i0; i <= i1; i++){
+                m_dirtyTiles.insert(j * m_columns + i);
+            }
+        }
+    }
+
+    void TiledLightingArea::markAllDirty(){
+        for(auto& tile: m_tiles){
+            m_dirtyTiles.insert(tile.first);
+        }
+        for(auto& entry: m_lights){
+            markDirty(entry.light->getGlobalBounds());
+        }
+    }
+
+    sf::Color TiledLightingArea::getActualColor() const{
+        sf::Color ret(m_color);
+        ret.a *= m_opacity;
+        return ret;
+    }
+
+    void TiledLightingArea::setAreaColor(sf::Color color){
+        m_color = color;
+        for(auto& tile: m_tiles){
+            tile.second->setAreaColor(color);
+        }
+        markAllDirty();
+    }
+
+    sf::Color TiledLightingArea::getAreaColor() const{
+        return m_color;
+    }
+
+    void TiledLightingArea::setAreaOpacity(float opacity){
+        m_opacity = opacity;
+        for(auto& tile: m_tiles){
+            tile.second->setAreaOpacity(opacity);
+        }
+        markAllDirty();
+    }
+
+    float TiledLightingArea::getAreaOpacity() const{
+        return m_opacity;
+    }
+
+    LightingArea::Mode TiledLightingArea::getMode() const{
+        return m_mode;
+    }
+
+    void TiledLightingArea::addLight(const LightSource& light){
+        LightEntry entry;
+        entry.light = &light;
+        entry.bounds = light.getGlobalBounds();
+        m_lights.push_back(entry);
+        markDirty(entry.bounds);
+    }
+
+    void TiledLightingArea::removeLight(const LightSource& light){
+        for(auto it = m_lights.begin(); it != m_lights.end(); it++){
+            if(it->light == &light){
+                markDirty(it->bounds);
+                m_lights.erase(it);
+                return;
+            }
+        }
+    }
+
+    void TiledLightingArea::invalidate(const LightSource& light){
+        for(auto& entry: m_lights){
+            if(entry.light == &light){
+                markDirty(entry.bounds);
+                entry.bounds = light.getGlobalBounds();
+                markDirty(entry.bounds);
+                return;
+            }
+        }
+    }
+
+    void TiledLightingArea::invalidate(const sf::FloatRect& region){
+        markDirty(region);
+    }
+
+    void TiledLightingArea::update(){
+        std::vector<const LightSource*> lights;
+        for(int tile: m_dirtyTiles){
+            sf::FloatRect tileBounds = getTileBounds(tile);
+            lights.clear();
+            if(m_mode == LightingArea::FOG && m_opacity > 0.f){
+                for(auto& entry: m_lights){
+                    if(entry.bounds.intersects(tileBounds)){
+                        lights.push_back(entry.light);
+                    }
+                }
+            }
+            if(lights.empty()){
+                // Plain tiles are drawn without a render texture
+                m_tiles.erase(tile);
+                continue;
+            }
+            std::unique_ptr<LightingArea>& area = m_tiles[tile];
+            if(!area){
+                area.reset(new LightingArea(
+                    m_mode,
+                    sf::Vector2f(tileBounds.left, tileBounds.top),
+                    sf::Vector2f(tileBounds.width, tileBounds.height),
+                    m_backend));
+                area->setAreaColor(m_color);
+                area->setAreaOpacity(m_opacity);
+            }
+            area->clear();
+            for(auto light: lights){
+                area->draw(*light);
+            }
+            area->display();
+        }
+        m_dirtyTiles.clear();
+    }
+
+    void TiledLightingArea::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        if(m_opacity <= 0.f){
+            return;
+        }
+        sf::FloatRect r;
+        if(!m_bounds.intersects(getViewBounds(t.getView()), r)){
+            return;
+        }
+        int i0 = std::max(0, (int)((r.left - m_bounds.left) / m_tileSize));
+        int j0 = std::max(0, (int)((r.top - m_bounds.top) / m_tileSize));
+        int i1 = std::min(m_columns - 1, (int)((r.left + r.width - m_bounds.left) / m_tileSize));
+        int j1 = std::min(m_rows - 1, (int)((r.top + r.height - m_bounds.top) / m_tileSize));
+
+        sf::VertexArray plain(sf::Quads);
+        sf::Color color = getActualColor();
+        for(int j = j0; j <= j1; j++){
+            for(int i = i0; i <= i1; i++){
+                int tile = j * m_columns + i;
+                auto it = m_tiles.find(tile);
+                if(it != m_tiles.end()){
+                    t.draw(*it->second, st);
+                }else{
+                    sf::FloatRect b = getTileBounds(tile);
+                    plain.append(sf::Vertex({b.left, b.top}, color));
+                    plain.append(sf::Vertex({b.left + b.width, b.top}, color));
+                    plain.append(sf::Vertex({b.left + b.width, b.top + b.height}, color));
+                    plain.append(sf::Vertex({b.left, b.top + b.height}, color));
+                }
+            }
+        }
+        if(plain.getVertexCount() > 0){
+            if(m_mode == LightingArea::AMBIENT){
+                st.blendMode = sf::BlendAdd;
+            }
+            t.draw(plain, st);
+        }
+    }
+}
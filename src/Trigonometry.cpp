@@ -0,0 +1,35 @@
+#include "Candle/geometry/Trigonometry.hpp"
+
+#include <cmath>
+
+#include "Candle/Constants.hpp"
+
+namespace sfu{
+#ifdef CANDLE_FAST_TRIG
+    void sincos(float degrees, float& sin, float& cos){
+        // Reduce to [-45, 45] degrees. The reduction is done in degrees
+        // because multiples of 90 are exact
+        float k = std::floor(degrees/90.f + 0.5f);
+        float r = (degrees - 90.f*k) * sfu::PI/180.f;
+        float z = r*r;
+        // Minimax polynomials for [-PI/4, PI/4] (from Cephes)
+        float s = r + r*z*(-1.6666654611e-1f + z*(8.3321608736e-3f + z*-1.9515295891e-4f));
+        float c = 1.f - 0.5f*z + z*z*(4.166664568298827e-2f + z*(-1.388731625493765e-3f + z*2.443315711809948e-5f));
+        switch((long long)k & 3){
+            case 0: sin = s;  cos = c;  break;
+            case 1: sin = c;  cos = -s; break;
+            case 2: sin = -s; cos = -c; break;
+            default: sin = -c; cos = s; break;
+        }
+    }
+#else
+    void sincos(float degrees, float& sin, float& cos){
+        const auto PI2 = sfu::PI*2;
+        float ang = (float)fmod(degrees*sfu::PI/180.f + sfu::PI , PI2);
+        if(ang < 0) ang += PI2;
+        ang -= sfu::PI;
+        sin = std::sin(ang);
+        cos = std::cos(ang);
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+#include "Candle/Visibility.hpp"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "Candle/geometry/BasicLine.hpp"
+
+namespace candle{
+    namespace{
+        // The predicates are evaluated in double, where the differences and
+        // products of float coordinates don't lose precision
+        typedef std::vector<sfu::BasicLine<double>> Segments;
+
+        void toSegments(const std::vector<sfu::Line>& edges, Segments& segments){
+            segments.reserve(edges.size());
+            for(auto& e: edges){
+                segments.emplace_back(sf::Vector2<double>(e.m_origin), sf::Vector2<double>(e.point(1.f)));
+            }
+        }
+    }
+
+    void computeVisibility(const std::vector<sfu::Line>& edges,
+                           const Viewpoint& viewpoint,
+                           std::vector<sf::Vector2f>& polygon){
+        Segments segments;
+        toSegments(edges, segments);
+        sfu::castVisibility(segments.cbegin(), segments.cend(), sf::Vector2<double>(viewpoint.position), (double)viewpoint.range, polygon);
+    }
+
+    void computeVisibility(const std::vector<sfu::Line>& edges,
+                           const std::vector<Viewpoint>& viewpoints,
+                           std::vector<std::vector<sf::Vector2f>>& polygons,
+                           unsigned int threads){
+        Segments segments;
+        toSegments(edges, segments);
+        polygons.resize(viewpoints.size());
+        if(threads == 0){
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min<size_t>(threads, viewpoints.size());
+        auto computeRange = [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                sfu::castVisibility(segments.cbegin(), segments.cend(), sf::Vector2<double>(viewpoints[i].position), (double)viewpoints[i].range, polygons[i]);
+            }
+        };
+        if(threads <= 1){
+            computeRange(0, viewpoints.size());
+            return;
+        }
+        // The viewpoints are interleaved in small chunks, so threads get
+        // similar work even if the crowded areas are contiguous
+        size_t chunk = std::max<size_t>(1, viewpoints.size() / (threads * 8));
+        std::vector<std::future<void>> workers;
+        for(unsigned int t = 0; t < threads; t++){
+            workers.push_back(std::async(std::launch::async, [&, t](){
+                for(size_t first = t * chunk; first < viewpoints.size(); first += threads * chunk){
+                    computeRange(first, std::min(first + chunk, viewpoints.size()));
+                }
+            }));
+        }
+        for(auto& w: workers){
+            w.get();
+        }
+    }
+}
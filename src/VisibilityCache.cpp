@@ -0,0 +1,142 @@
+#include "Candle/VisibilityCache.hpp"
+
+#include <cmath>
+#include <functional>
+
+#include "Candle/RadialLight.hpp"
+#include "Candle/DirectedLight.hpp"
+
+namespace candle{
+    float VisibilityCache::Statistics::getHitRate() const{
+        unsigned long total = hits + misses;
+        return total == 0 ? 0.f : (float)hits / total;
+    }
+
+    bool VisibilityCache::Key::operator == (const Key& other) const{
+        return type == other.type
+            && version == other.version
+            && x == other.x
+            && y == other.y
+            && rotation == other.rotation
+            && scaleX == other.scaleX
+            && scaleY == other.scaleY
+            && range == other.range
+            && beam == other.beam;
+    }
+
+    size_t VisibilityCache::KeyHash::operator () (const Key& key) const{
+        size_t h = std::hash<const void*>()(key.type);
+        auto combine = [&h](size_t v){
+            h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+        };
+        combine(std::hash<unsigned long>()(key.version));
+        combine(std::hash<int>()(key.x));
+        combine(std::hash<int>()(key.y));
+        combine(std::hash<int>()(key.rotation));
+        combine(std::hash<float>()(key.scaleX));
+        combine(std::hash<float>()(key.scaleY));
+        combine(std::hash<float>()(key.range));
+        combine(std::hash<float>()(key.beam));
+        return h;
+    }
+
+    VisibilityCache::VisibilityCache(size_t maxMemory, float positionStep, float angleStep)
+        : m_positionStep(positionStep)
+        , m_angleStep(angleStep)
+        , m_maxMemory(maxMemory)
+        , m_version(0)
+        , m_statistics()
+        {}
+
+    VisibilityCache::Key VisibilityCache::makeKey(const LightSource& light) const{
+        Key key;
+        key.type = &typeid(light);
+        key.version = m_version;
+        sf::Vector2f position = light.getPosition();
+        key.x = (int)std::floor(position.x / m_positionStep + 0.5f);
+        key.y = (int)std::floor(position.y / m_positionStep + 0.5f);
+        key.rotation = (int)std::floor(light.getRotation() / m_angleStep + 0.5f);
+        key.scaleX = light.getScale().x;
+        key.scaleY = light.getScale().y;
+        key.range = light.getRange();
+        key.beam = 0.f;
+        if(auto radial = dynamic_cast<const RadialLight*>(&light)){
+            key.beam = radial->getBeamAngle();
+        }else if(auto directed = dynamic_cast<const DirectedLight*>(&light)){
+            key.beam = directed->getBeamWidth();
+        }
+        return key;
+    }
+
+    size_t VisibilityCache::getMemory(const sf::VertexArray& polygon){
+        return polygon.getVertexCount() * sizeof(sf::Vertex) + sizeof(Entry);
+    }
+
+    void VisibilityCache::evict(){
+        while(m_statistics.memory > m_maxMemory && !m_entries.empty()){
+            Entry& last = m_entries.back();
+            m_statistics.memory -= getMemory(last.polygon);
+            m_index.erase(last.key);
+            m_entries.pop_back();
+            m_statistics.evictions++;
+        }
+        m_statistics.entries = m_entries.size();
+    }
+
+    void VisibilityCache::setEdgeVersion(unsigned long version){
+        m_version = version;
+    }
+
+    unsigned long VisibilityCache::getEdgeVersion() const{
+        return m_version;
+    }
+
+    void VisibilityCache::setMaxMemory(size_t bytes){
+        m_maxMemory = bytes;
+        evict();
+    }
+
+    size_t VisibilityCache::getMaxMemory() const{
+        return m_maxMemory;
+    }
+
+    bool VisibilityCache::castLight(LightSource& light, const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        Key key = makeKey(light);
+        auto it = m_index.find(key);
+        if(it != m_index.end()){
+            // Move the entry to the front, as the most recently used
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            light.m_polygon = it->second->polygon;
+            light.resetColor();
+            m_statistics.hits++;
+            return true;
+        }
+        m_statistics.misses++;
+        light.castLight(begin, end);
+        Entry entry;
+        entry.key = key;
+        entry.polygon = light.m_polygon;
+        m_statistics.memory += getMemory(entry.polygon);
+        m_entries.push_front(entry);
+        m_index[key] = m_entries.begin();
+        evict();
+        return false;
+    }
+
+    void VisibilityCache::clear(){
+        m_entries.clear();
+        m_index.clear();
+        m_statistics.entries = 0;
+        m_statistics.memory = 0;
+    }
+
+    VisibilityCache::Statistics VisibilityCache::getStatistics() const{
+        return m_statistics;
+    }
+
+    void VisibilityCache::resetStatistics(){
+        m_statistics.hits = 0;
+        m_statistics.misses = 0;
+        m_statistics.evictions = 0;
+    }
+}
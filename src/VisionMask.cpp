@@ -0,0 +1,156 @@
+#include "Candle/VisionMask.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace candle{
+    // Cut the fans to the circle of the range. The texture coordinates are
+    // the offset from the viewpoint divided by the range.
+    float l_visionCircle(const sf::Vector2f& tc){
+        return tc.x*tc.x + tc.y*tc.y <= 1.f ? 1.f : 0.f;
+    }
+
+    VisionMask::VisionMask(float texelSize)
+        : m_texelSize(texelSize)
+        , m_threads(0)
+        , m_textureOutdated(false)
+        , m_quad(sf::Quads, 4)
+        {}
+
+    size_t VisionMask::addViewpoint(const sf::Vector2f& position, float range){
+        Viewpoint v;
+        v.position = position;
+        v.range = range;
+        m_viewpoints.push_back(v);
+        return m_viewpoints.size() - 1;
+    }
+
+    void VisionMask::setViewpoint(size_t i, const sf::Vector2f& position, float range){
+        m_viewpoints[i].position = position;
+        m_viewpoints[i].range = range;
+    }
+
+    void VisionMask::clearViewpoints(){
+        m_viewpoints.clear();
+    }
+
+    size_t VisionMask::getViewpointCount() const{
+        return m_viewpoints.size();
+    }
+
+    void VisionMask::setTexelSize(float size){
+        m_texelSize = size;
+    }
+
+    float VisionMask::getTexelSize() const{
+        return m_texelSize;
+    }
+
+    void VisionMask::setThreadCount(unsigned int threads){
+        m_threads = threads;
+    }
+
+    void VisionMask::compute(const EdgeVector::iterator& begin, const EdgeVector::iterator& end){
+        if(m_viewpoints.empty()){
+            m_polygons.clear();
+            m_bounds = sf::FloatRect();
+            m_mask.create(0, 0);
+            m_image = sf::Image();
+            m_textureOutdated = true;
+            return;
+        }
+        float left = m_viewpoints[0].position.x, top = m_viewpoints[0].position.y;
+        float right = left, bottom = top;
+        for(auto& v: m_viewpoints){
+            left = std::min(left, v.position.x - v.range);
+            top = std::min(top, v.position.y - v.range);
+            right = std::max(right, v.position.x + v.range);
+            bottom = std::max(bottom, v.position.y + v.range);
+        }
+        unsigned int width = (unsigned int)std::ceil((right - left) / m_texelSize) + 1;
+        unsigned int height = (unsigned int)std::ceil((bottom - top) / m_texelSize) + 1;
+        m_bounds = sf::FloatRect(left, top, width * m_texelSize, height * m_texelSize);
+
+        // The edges out of the group are discarded once for all viewpoints
+        std::vector<sfu::Line> edges;
+        for(auto it = begin; it != end; it++){
+            if(m_bounds.intersects(it->getGlobalBounds())){
+                edges.push_back(*it);
+            }
+        }
+        computeVisibility(edges, m_viewpoints, m_polygons, m_threads);
+
+        m_mask.create(width, height);
+        m_mask.clear(sf::Color::Transparent);
+        sf::RenderStates maskStates(sf::BlendAdd);
+        maskStates.transform.scale(1.f / m_texelSize, 1.f / m_texelSize);
+        maskStates.transform.translate(-left, -top);
+        sf::VertexArray fan(sf::TriangleFan);
+        for(size_t i = 0; i < m_viewpoints.size(); i++){
+            const Viewpoint& v = m_viewpoints[i];
+            const std::vector<sf::Vector2f>& polygon = m_polygons[i];
+            if(polygon.empty() || v.range <= 0.f){
+                continue;
+            }
+            fan.resize(polygon.size() + 2);
+            fan[0] = sf::Vertex(v.position, sf::Color::White, {0.f, 0.f});
+            for(size_t j = 0; j <= polygon.size(); j++){
+                const sf::Vector2f& p = polygon[j % polygon.size()];
+                fan[j+1] = sf::Vertex(p, sf::Color::White, (p - v.position) / v.range);
+            }
+            m_mask.draw(fan, maskStates, l_visionCircle);
+        }
+        m_image = m_mask.copyToImage();
+        m_textureOutdated = true;
+
+        m_quad[0].position = {left, top};
+        m_quad[1].position = {m_bounds.left + m_bounds.width, top};
+        m_quad[2].position = {m_bounds.left + m_bounds.width, m_bounds.top + m_bounds.height};
+        m_quad[3].position = {left, m_bounds.top + m_bounds.height};
+        m_quad[0].texCoords = {0.f, 0.f};
+        m_quad[1].texCoords = {(float)width, 0.f};
+        m_quad[2].texCoords = {(float)width, (float)height};
+        m_quad[3].texCoords = {0.f, (float)height};
+    }
+
+    const std::vector<sf::Vector2f>& VisionMask::getPolygon(size_t i) const{
+        return m_polygons[i];
+    }
+
+    bool VisionMask::isVisible(const sf::Vector2f& point) const{
+        if(!m_bounds.contains(point)){
+            return false;
+        }
+        sf::Vector2u size = m_mask.getSize();
+        unsigned int x = std::min(size.x - 1, (unsigned int)((point.x - m_bounds.left) / m_texelSize));
+        unsigned int y = std::min(size.y - 1, (unsigned int)((point.y - m_bounds.top) / m_texelSize));
+        return m_mask.getPixel(x, y).a >= 128;
+    }
+
+    sf::FloatRect VisionMask::getGlobalBounds() const{
+        return m_bounds;
+    }
+
+    void VisionMask::draw(sf::RenderTarget& t, sf::RenderStates st) const{
+        if(m_image.getSize().x == 0){
+            return;
+        }
+        if(m_textureOutdated){
+            m_texture.loadFromImage(m_image);
+            m_texture.setSmooth(true);
+            m_textureOutdated = false;
+        }
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        st.texture = &m_texture;
+        t.draw(m_quad, st);
+    }
+
+    void VisionMask::rasterize(sfu::SoftwareTarget& t, sf::RenderStates st) const{
+        if(st.blendMode == sf::BlendAlpha){ // the default
+            st.blendMode = sf::BlendAdd;
+        }
+        t.draw(m_quad, st, m_image);
+    }
+}